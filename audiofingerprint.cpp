@@ -0,0 +1,839 @@
+#include "audiofingerprint.h"
+#include <QDir>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QVarLengthArray>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+// 分析参数: 1024点帧，512点帧移(32ms)，300~2000Hz之间33个对数频带
+static const double kPi = 3.14159265358979323846;
+static const int kSampleRate = 16000;
+static const int kFrameSize = 1024;
+static const int kHopSize = 512;
+static const int kBandCount = 33;
+static const double kMinFreq = 300.0;
+static const double kMaxFreq = 2000.0;
+// 低于该均方值(约-60dBFS)的帧视为静音，子指纹记为0，不参与查找
+static const double kSilenceMeanSquare = 1e-6;
+
+// 索引参数
+static const char kIndexMagic[8] = { 'V', '2', 'S', 'F', 'P', 'I', 'X', '1' };
+static const int kIndexHeaderSize = 16;
+static const int kIndexStride = 4;          // 历史录音每4帧建立一个哈希，查询时逐帧查找
+static const int kMaxHitsPerHash = 64;      // 过于常见的哈希不参与投票
+static const int kWeakBits = 3;             // 查找时翻转每帧最不可靠的3位，共尝试8个值
+static const int kMinVotes = 4;
+static const int kMaxCandidates = 32;
+static const int kBlockFrames = 64;         // 约2秒为一个比对块
+static const double kMaxBitErrorRate = 0.35;
+static const qint64 kMinMatchMs = 4000;
+static const qint64 kTailMarginMs = 2000;
+
+struct EntryLess {
+    template <typename T>
+    bool operator()(const T &a, const T &b) const
+    {
+        if (a.hash != b.hash) return a.hash < b.hash;
+        if (a.recordId != b.recordId) return a.recordId < b.recordId;
+        return a.frame < b.frame;
+    }
+};
+
+struct HashLess {
+    template <typename T>
+    bool operator()(const T &entry, quint32 hash) const { return entry.hash < hash; }
+    template <typename T>
+    bool operator()(quint32 hash, const T &entry) const { return hash < entry.hash; }
+};
+
+// 字幕的JSON表示，逐词时间保存为 [起始, 结束, 文本, 置信度] 数组
+static QJsonArray cuesToJson(const QVector<SubtitleCue> &cues)
+{
+    QJsonArray cueArray;
+    for (const SubtitleCue &cue : cues) {
+        QJsonObject obj;
+        obj["start"] = cue.startMs;
+        obj["end"] = cue.endMs;
+        obj["text"] = cue.text;
+
+        if (!cue.words.isEmpty()) {
+            QJsonArray words;
+            for (const SubtitleWord &word : cue.words) {
+                words.append(QJsonArray({ word.startMs, word.endMs, word.text, word.confidence }));
+            }
+            obj["words"] = words;
+        }
+        cueArray.append(obj);
+    }
+    return cueArray;
+}
+
+static QVector<SubtitleCue> cuesFromJson(const QJsonArray &cueArray)
+{
+    QVector<SubtitleCue> cues;
+    for (const QJsonValue &value : cueArray) {
+        QJsonObject obj = value.toObject();
+        SubtitleCue cue;
+        cue.startMs = static_cast<qint64>(obj["start"].toDouble());
+        cue.endMs = static_cast<qint64>(obj["end"].toDouble());
+        cue.text = obj["text"].toString();
+
+        for (const QJsonValue &wordValue : obj["words"].toArray()) {
+            QJsonArray fields = wordValue.toArray();
+            cue.words.append({ static_cast<qint64>(fields[0].toDouble()),
+                               static_cast<qint64>(fields[1].toDouble()),
+                               fields[2].toString(),
+                               fields[3].toDouble() });
+        }
+        cues.append(cue);
+    }
+    return cues;
+}
+
+// 原地基2快速傅里叶变换
+static void fft(std::complex<float> *buf, int n, const std::vector<std::complex<float>> &twiddles)
+{
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(buf[i], buf[j]);
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < len / 2; ++k) {
+                std::complex<float> t = twiddles[k * step] * buf[i + k + len / 2];
+                buf[i + k + len / 2] = buf[i + k] - t;
+                buf[i + k] += t;
+            }
+        }
+    }
+}
+
+// 在WAV文件中定位PCM数据，只接受16kHz单声道16位格式
+static bool findPcmData(const uchar *data, qint64 size, const uchar **pcm, qint64 *sampleCount)
+{
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool formatOk = false;
+    qint64 pos = 12;
+    while (pos + 8 <= size) {
+        const uchar *chunk = data + pos;
+        qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && pos + 8 + 16 <= size) {
+            quint16 audioFormat = qFromLittleEndian<quint16>(chunk + 8);
+            quint16 channels = qFromLittleEndian<quint16>(chunk + 10);
+            quint32 sampleRate = qFromLittleEndian<quint32>(chunk + 12);
+            quint16 bitsPerSample = qFromLittleEndian<quint16>(chunk + 22);
+            formatOk = audioFormat == 1 && channels == 1 &&
+                       sampleRate == kSampleRate && bitsPerSample == 16;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!formatOk) {
+                return false;
+            }
+            // 未正常收尾的文件数据长度可能不正确，以实际文件大小为准
+            qint64 available = size - pos - 8;
+            *pcm = chunk + 8;
+            *sampleCount = qMin(chunkSize, available) / 2;
+            return true;
+        }
+
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+// 帧没有对齐时子指纹常有个别位翻转，与上一版本对齐时同时尝试原值和每一位翻转后的值(bit 为 -1 表示原值)
+static inline quint32 probeHash(quint32 hash, int bit)
+{
+    return bit < 0 ? hash : hash ^ (1u << bit);
+}
+
+// 取票数最高的若干候选，键为 (录音ID << 32 | 帧偏移)
+static QVector<quint64> topCandidates(const QHash<quint64, int> &votes)
+{
+    QVector<QPair<int, quint64>> candidates;
+    for (auto it = votes.constBegin(); it != votes.constEnd(); ++it) {
+        if (it.value() >= kMinVotes) {
+            candidates.append(qMakePair(it.value(), it.key()));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const QPair<int, quint64> &a, const QPair<int, quint64> &b) {
+        return a.first > b.first;
+    });
+
+    QVector<quint64> result;
+    for (int i = 0; i < candidates.size() && i < kMaxCandidates; ++i) {
+        result.append(candidates[i].second);
+    }
+    return result;
+}
+
+// 按给定帧偏移逐块比较误码率，返回连续匹配的区间(当前音频的帧号)
+static QVector<QPair<int, int>> verifyAlignment(const QVector<quint32> &fingerprint, const QVector<quint32> &ref, qint32 offset,
+                                                const QAtomicInt *cancel)
+{
+    QVector<QPair<int, int>> runs;
+
+    int lo = qMax(0, -offset);
+    int hi = qMin(fingerprint.size(), ref.size() - offset);
+    int runStart = -1;
+    int runEnd = -1;
+    for (int blockStart = lo; blockStart < hi; blockStart += kBlockFrames) {
+        if (cancel && cancel->loadRelaxed()) {
+            return QVector<QPair<int, int>>();
+        }
+
+        int blockEnd = qMin(hi, blockStart + kBlockFrames);
+        int bits = 0;
+        int errors = 0;
+        int oneSided = 0;
+        for (int i = blockStart; i < blockEnd; ++i) {
+            quint32 q = fingerprint[i];
+            quint32 r = ref[i + offset];
+            if (q == 0 || r == 0) {
+                if (q != r) {
+                    oneSided++;
+                }
+                continue;
+            }
+            bits += 32;
+            errors += qPopulationCount(q ^ r);
+        }
+
+        // 一方有声而另一方静音说明内容已不同；两边大部分都是静音的块无法判断，不中断也不开始连续区间
+        bool silenceMismatch = oneSided >= kBlockFrames / 4;
+        if (bits < 32 * kBlockFrames / 4 && !silenceMismatch) {
+            continue;
+        }
+
+        if (!silenceMismatch && errors < bits * kMaxBitErrorRate) {
+            if (runStart < 0) {
+                runStart = blockStart;
+            }
+            runEnd = blockEnd;
+        } else if (runStart >= 0) {
+            runs.append(qMakePair(runStart, runEnd));
+            runStart = -1;
+        }
+    }
+    if (runStart >= 0) {
+        runs.append(qMakePair(runStart, runEnd));
+    }
+
+    return runs;
+}
+
+// 依次验证候选对齐，把区间内完整的历史字幕平移到当前时间轴，结果互不重叠；取消时返回空
+template <typename FingerprintOf, typename CuesOf>
+static QVector<FingerprintMatch> collectMatches(const QVector<quint32> &fingerprint, const QVector<quint64> &candidates,
+                                                FingerprintOf fingerprintOf, CuesOf cuesOf, const QAtomicInt *cancel)
+{
+    QVector<FingerprintMatch> matches;
+    QVector<bool> claimed(fingerprint.size(), false);
+
+    for (quint64 candidate : candidates) {
+        if (cancel && cancel->loadRelaxed()) {
+            return QVector<FingerprintMatch>();
+        }
+
+        qint32 recordId = static_cast<qint32>(candidate >> 32);
+        qint32 offset = static_cast<qint32>(candidate & 0xffffffffu);
+        const QVector<quint32> &ref = fingerprintOf(recordId);
+
+        for (const auto &run : verifyAlignment(fingerprint, ref, offset, cancel)) {
+            if (qint64(run.second - run.first) * AudioFingerprintIndex::kFrameMs < kMinMatchMs) {
+                continue;
+            }
+            if (std::find(claimed.begin() + run.first, claimed.begin() + run.second, true) != claimed.begin() + run.second) {
+                continue;
+            }
+
+            qint64 refStartMs = qint64(run.first + offset) * AudioFingerprintIndex::kFrameMs;
+            qint64 refEndMs = qint64(run.second + offset) * AudioFingerprintIndex::kFrameMs + (kFrameSize - kHopSize) * 1000 / kSampleRate;
+            qint64 shiftMs = -qint64(offset) * AudioFingerprintIndex::kFrameMs;
+
+            // 历史录音在此处结束而当前音频还在继续时(如录制中的文件)，最后一条字幕可能被截断
+            if (run.second + offset >= ref.size() && run.second < fingerprint.size()) {
+                refEndMs -= kTailMarginMs;
+            }
+
+            // 只复用完整落在重复区间内的字幕
+            FingerprintMatch match;
+            match.recordId = recordId;
+            for (const SubtitleCue &cue : cuesOf(recordId)) {
+                if (cue.startMs >= refStartMs && cue.endMs <= refEndMs) {
+                    SubtitleCue shifted = cue;
+                    shifted.startMs += shiftMs;
+                    shifted.endMs += shiftMs;
+                    for (SubtitleWord &word : shifted.words) {
+                        word.startMs += shiftMs;
+                        word.endMs += shiftMs;
+                    }
+                    match.cues.append(shifted);
+                }
+            }
+            if (match.cues.isEmpty()) {
+                continue;
+            }
+
+            match.startMs = match.cues.first().startMs;
+            match.endMs = match.cues.last().endMs;
+            std::fill(claimed.begin() + run.first, claimed.begin() + run.second, true);
+            matches.append(match);
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const FingerprintMatch &a, const FingerprintMatch &b) {
+        return a.startMs < b.startMs;
+    });
+    return matches;
+}
+
+AudioFingerprintIndex::AudioFingerprintIndex(const QString &dirPath)
+    : dirPath(dirPath)
+    , segments(dirPath, QByteArray(kIndexMagic, sizeof(kIndexMagic)), kIndexHeaderSize)
+    , nextRecordId(1)
+    , nextSegmentId(1)
+{
+    QStringList names;
+
+    QFile file(dirPath + "/records.json");
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        file.close();
+
+        QJsonObject obj = doc.object();
+        nextRecordId = obj.value("nextId").toInt(1);
+        nextSegmentId = obj.value("nextSegment").toInt(1);
+
+        QJsonObject records = obj.value("records").toObject();
+        for (auto it = records.begin(); it != records.end(); ++it) {
+            sources.insert(it.key().toInt(), it.value().toString());
+        }
+
+        for (const QJsonValue &value : obj.value("segments").toArray()) {
+            names.append(value.toString());
+        }
+    }
+
+    // 段已写入但 records.json 未更新时中断留下的文件
+    SegmentSet::removeUnlisted(dirPath, QStringList() << "seg_*.bin", names);
+    segments.append(names);
+}
+
+QVector<quint32> AudioFingerprintIndex::fingerprintWav(const QString &wavPath, const QAtomicInt *cancel,
+                                                       QVector<quint32> *weakBits)
+{
+    QVector<quint32> result;
+    if (weakBits != nullptr) {
+        weakBits->clear();
+    }
+
+    QFile file(wavPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    const uchar *data = file.map(0, file.size());
+    const uchar *pcm = nullptr;
+    qint64 sampleCount = 0;
+    if (data == nullptr || !findPcmData(data, file.size(), &pcm, &sampleCount) || sampleCount < kFrameSize) {
+        return result;
+    }
+
+    // 预先计算窗函数、旋转因子和频带边界
+    std::vector<float> window(kFrameSize);
+    for (int i = 0; i < kFrameSize; ++i) {
+        window[i] = 0.5f - 0.5f * std::cos(2.0 * kPi * i / (kFrameSize - 1));
+    }
+
+    std::vector<std::complex<float>> twiddles(kFrameSize / 2);
+    for (int k = 0; k < kFrameSize / 2; ++k) {
+        twiddles[k] = std::polar(1.0f, static_cast<float>(-2.0 * kPi * k / kFrameSize));
+    }
+
+    int bandEdges[kBandCount + 1];
+    for (int b = 0; b <= kBandCount; ++b) {
+        double freq = kMinFreq * std::pow(kMaxFreq / kMinFreq, static_cast<double>(b) / kBandCount);
+        bandEdges[b] = static_cast<int>(std::lround(freq * kFrameSize / kSampleRate));
+    }
+
+    qint64 frameCount = (sampleCount - kFrameSize) / kHopSize + 1;
+    result.reserve(static_cast<int>(frameCount));
+    if (weakBits != nullptr) {
+        weakBits->reserve(static_cast<int>(frameCount));
+    }
+
+    std::vector<std::complex<float>> buf(kFrameSize);
+    double energy[kBandCount] = {};
+    double prevEnergy[kBandCount] = {};
+
+    for (qint64 frame = 0; frame < frameCount; ++frame) {
+        if (cancel && cancel->loadRelaxed()) {
+            if (weakBits != nullptr) {
+                weakBits->clear();
+            }
+            return QVector<quint32>();
+        }
+
+        const uchar *frameData = pcm + frame * kHopSize * 2;
+        double meanSquare = 0;
+        for (int i = 0; i < kFrameSize; ++i) {
+            float sample = qFromLittleEndian<qint16>(frameData + i * 2) / 32768.0f;
+            meanSquare += sample * sample;
+            buf[i] = std::complex<float>(sample * window[i], 0.0f);
+        }
+        meanSquare /= kFrameSize;
+
+        fft(buf.data(), kFrameSize, twiddles);
+
+        for (int b = 0; b < kBandCount; ++b) {
+            double sum = 0;
+            for (int k = bandEdges[b]; k < bandEdges[b + 1]; ++k) {
+                sum += std::norm(buf[k]);
+            }
+            energy[b] = sum;
+        }
+
+        // 相邻频带能量差在时间方向上的变化取符号，得到32位子指纹
+        // 差值绝对值最小的几位最容易因噪声或帧没有对齐而翻转
+        quint32 bits = 0;
+        quint32 weak = 0;
+        if (meanSquare >= kSilenceMeanSquare) {
+            double magnitude[32];
+            for (int m = 0; m < 32; ++m) {
+                double delta = (energy[m] - energy[m + 1]) - (prevEnergy[m] - prevEnergy[m + 1]);
+                if (delta > 0) {
+                    bits |= 1u << m;
+                }
+                magnitude[m] = std::abs(delta);
+            }
+            for (int k = 0; k < kWeakBits; ++k) {
+                int weakest = -1;
+                for (int m = 0; m < 32; ++m) {
+                    if (!(weak & (1u << m)) && (weakest < 0 || magnitude[m] < magnitude[weakest])) {
+                        weakest = m;
+                    }
+                }
+                weak |= 1u << weakest;
+            }
+        }
+        result.append(bits);
+        if (weakBits != nullptr) {
+            weakBits->append(weak);
+        }
+
+        std::copy(energy, energy + kBandCount, prevEnergy);
+    }
+
+    return result;
+}
+
+QVector<FingerprintMatch> AudioFingerprintIndex::lookup(const QVector<quint32> &fingerprint, const QVector<quint32> &weakBits,
+                                                        bool requireWords, const QAtomicInt *cancel)
+{
+    QMutexLocker locker(&mutex);
+    QVector<FingerprintMatch> matches;
+
+    if (segments.segments().isEmpty() || fingerprint.isEmpty()) {
+        return matches;
+    }
+
+    // 逐帧在各段中查找哈希，按 (录音ID, 帧偏移) 投票
+    QHash<quint64, int> votes;
+    QVarLengthArray<std::pair<const IndexEntry *, const IndexEntry *>, 16> ranges;
+    for (int i = 0; i < fingerprint.size(); ++i) {
+        if (cancel && cancel->loadRelaxed()) {
+            return matches;
+        }
+
+        if (fingerprint[i] == 0) {
+            continue;
+        }
+
+        // 依次尝试原值和翻转最不可靠各位组合后的值(weak 的所有子集)
+        quint32 weak = i < weakBits.size() ? weakBits[i] : 0;
+        quint32 flip = 0;
+        do {
+            quint32 hash = fingerprint[i] ^ flip;
+            qint64 hits = 0;
+            ranges.clear();
+            for (const SegmentSet::Segment &segment : segments.segments()) {
+                const IndexEntry *entries;
+                quint64 count = segmentEntries(segment, &entries);
+                auto range = std::equal_range(entries, entries + count, hash, HashLess());
+                hits += range.second - range.first;
+                ranges.append(range);
+            }
+
+            if (hits <= kMaxHitsPerHash) {
+                for (const auto &range : ranges) {
+                    for (const IndexEntry *p = range.first; p != range.second; ++p) {
+                        qint32 offset = static_cast<qint32>(p->frame) - i;
+                        votes[(quint64(p->recordId) << 32) | quint32(offset)]++;
+                    }
+                }
+            }
+            flip = (flip - weak) & weak;
+        } while (flip != 0);
+    }
+
+    // 对候选对齐逐块计算误码率，连续低误码率的块构成重复片段
+    QHash<qint32, QVector<quint32>> fingerprintCache;
+    QHash<qint32, QVector<SubtitleCue>> cueCache;
+
+    return collectMatches(fingerprint, topCandidates(votes),
+        [&](qint32 recordId) -> const QVector<quint32> & {
+            if (!fingerprintCache.contains(recordId)) {
+                fingerprintCache.insert(recordId, loadRecordFingerprint(recordId));
+            }
+            return fingerprintCache[recordId];
+        },
+        [&](qint32 recordId) -> const QVector<SubtitleCue> & {
+            // 缺少逐词时间的录音没有可复用的字幕
+            if (!cueCache.contains(recordId)) {
+                bool wordTimings = false;
+                QVector<SubtitleCue> cues = loadRecordCues(recordId, &wordTimings);
+                cueCache.insert(recordId, requireWords && !wordTimings ? QVector<SubtitleCue>() : cues);
+            }
+            return cueCache[recordId];
+        },
+        cancel);
+}
+
+QVector<FingerprintMatch> AudioFingerprintIndex::alignRecording(const QVector<quint32> &fingerprint,
+                                                                const QVector<quint32> &previous,
+                                                                const QVector<SubtitleCue> &previousCues,
+                                                                const QAtomicInt *cancel)
+{
+    if (fingerprint.isEmpty() || previous.isEmpty()) {
+        return QVector<FingerprintMatch>();
+    }
+
+    // 上一版本的全部子指纹都参与查找
+    QHash<quint32, QVector<int>> frames;
+    for (int i = 0; i < previous.size(); ++i) {
+        if (previous[i] != 0) {
+            frames[previous[i]].append(i);
+        }
+    }
+
+    QHash<quint64, int> votes;
+    for (int i = 0; i < fingerprint.size(); ++i) {
+        if (cancel && cancel->loadRelaxed()) {
+            return QVector<FingerprintMatch>();
+        }
+
+        if (fingerprint[i] == 0) {
+            continue;
+        }
+
+        for (int bit = -1; bit < 32; ++bit) {
+            auto it = frames.constFind(probeHash(fingerprint[i], bit));
+            if (it == frames.constEnd() || it->size() > kMaxHitsPerHash) {
+                continue;
+            }
+            for (int frame : *it) {
+                votes[quint32(frame - i)]++;
+            }
+        }
+    }
+
+    return collectMatches(fingerprint, topCandidates(votes),
+        [&](qint32) -> const QVector<quint32> & { return previous; },
+        [&](qint32) -> const QVector<SubtitleCue> & { return previousCues; },
+        cancel);
+}
+
+bool AudioFingerprintIndex::loadRecordingState(const QString &path, QVector<quint32> *fingerprint, QVector<SubtitleCue> *cues,
+                                               bool *wordTimings)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+
+    QJsonObject obj = doc.object();
+    if (obj.value("version").toInt() != 1) {
+        return false;
+    }
+
+    QByteArray data = QByteArray::fromBase64(obj.value("fingerprint").toString().toLatin1());
+    fingerprint->resize(data.size() / static_cast<int>(sizeof(quint32)));
+    for (int i = 0; i < fingerprint->size(); ++i) {
+        (*fingerprint)[i] = qFromLittleEndian<quint32>(data.constData() + i * sizeof(quint32));
+    }
+
+    *cues = cuesFromJson(obj.value("cues").toArray());
+    *wordTimings = obj.value("wordTimings").toBool();
+
+    return !fingerprint->isEmpty();
+}
+
+bool AudioFingerprintIndex::saveRecordingState(const QString &path, const QVector<quint32> &fingerprint, const QVector<SubtitleCue> &cues,
+                                               bool wordTimings)
+{
+    QByteArray data(fingerprint.size() * static_cast<int>(sizeof(quint32)), Qt::Uninitialized);
+    for (int i = 0; i < fingerprint.size(); ++i) {
+        qToLittleEndian<quint32>(fingerprint[i], data.data() + i * sizeof(quint32));
+    }
+
+    QJsonObject obj;
+    obj["version"] = 1;
+    obj["fingerprint"] = QString::fromLatin1(data.toBase64());
+    obj["cues"] = cuesToJson(cues);
+    obj["wordTimings"] = wordTimings;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+bool AudioFingerprintIndex::addRecording(const QString &sourcePath,
+                                         const QVector<quint32> &fingerprint,
+                                         const QVector<SubtitleCue> &cues,
+                                         const QVector<QPair<qint64, qint64>> &skipSpans,
+                                         bool wordTimings)
+{
+    QMutexLocker locker(&mutex);
+
+    // 没有字幕的录音即使命中也无法复用
+    if (fingerprint.isEmpty() || cues.isEmpty()) {
+        return false;
+    }
+
+    if (!QDir().mkpath(dirPath)) {
+        return false;
+    }
+
+    qint32 recordId = nextRecordId;
+
+    // 保存完整子指纹序列，供查询时比对误码率
+    QSaveFile fpFile(recordPath(recordId, ".fp"));
+    if (!fpFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    fpFile.write(reinterpret_cast<const char *>(fingerprint.constData()), fingerprint.size() * sizeof(quint32));
+    if (!fpFile.commit()) {
+        return false;
+    }
+
+    // 保存字幕
+    QJsonObject cueRoot;
+    cueRoot["source"] = sourcePath;
+    cueRoot["cues"] = cuesToJson(cues);
+    cueRoot["wordTimings"] = wordTimings;
+
+    QSaveFile cueFile(recordPath(recordId, ".json"));
+    if (!cueFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    cueFile.write(QJsonDocument(cueRoot).toJson(QJsonDocument::Compact));
+    if (!cueFile.commit()) {
+        return false;
+    }
+
+    // 生成新哈希条目，跳过本身就是复用得到的区间
+    QVector<IndexEntry> added;
+    for (int frame = 0; frame < fingerprint.size(); frame += kIndexStride) {
+        if (fingerprint[frame] == 0) {
+            continue;
+        }
+
+        qint64 ms = qint64(frame) * kFrameMs;
+        bool skipped = false;
+        for (const auto &span : skipSpans) {
+            if (ms >= span.first && ms < span.second) {
+                skipped = true;
+                break;
+            }
+        }
+        if (!skipped) {
+            added.append({ fingerprint[frame], static_cast<quint32>(recordId), static_cast<quint32>(frame) });
+        }
+    }
+    std::sort(added.begin(), added.end(), EntryLess());
+
+    // 新条目写成单独的段，records.json 整体替换后才生效
+    QString name;
+    if (!added.isEmpty()) {
+        name = QString("seg_%1.bin").arg(nextSegmentId++);
+        if (!writeSegment(name, added)) {
+            return false;
+        }
+    }
+
+    sources.insert(recordId, sourcePath);
+    nextRecordId = recordId + 1;
+    if (!segments.commit(segments.segments().size(), name, [this](const QStringList &names) { return saveRecords(names); })) {
+        sources.remove(recordId);
+        nextRecordId = recordId;
+        return false;
+    }
+
+    for (int first = segments.mergeStart(); first >= 0; first = segments.mergeStart()) {
+        if (!mergeSegments(first)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AudioFingerprintIndex::saveRecords(const QStringList &segmentNames)
+{
+    QJsonObject records;
+    for (auto it = sources.constBegin(); it != sources.constEnd(); ++it) {
+        records[QString::number(it.key())] = it.value();
+    }
+
+    QJsonObject obj;
+    obj["records"] = records;
+    obj["nextId"] = nextRecordId;
+    obj["nextSegment"] = nextSegmentId;
+    obj["segments"] = QJsonArray::fromStringList(segmentNames);
+
+    QSaveFile file(dirPath + "/records.json");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(QJsonDocument(obj).toJson());
+    return file.commit();
+}
+
+quint64 AudioFingerprintIndex::segmentEntries(const SegmentSet::Segment &segment, const IndexEntry **entries)
+{
+    quint64 count;
+    memcpy(&count, segment.data + sizeof(kIndexMagic), sizeof(count));
+    *entries = reinterpret_cast<const IndexEntry *>(segment.data + kIndexHeaderSize);
+    return qMin(count, quint64(segment.size - kIndexHeaderSize) / sizeof(IndexEntry));
+}
+
+bool AudioFingerprintIndex::writeSegment(const QString &name, const QVector<IndexEntry> &entries)
+{
+    QSaveFile file(dirPath + "/" + name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    quint64 count = static_cast<quint64>(entries.size());
+    file.write(kIndexMagic, sizeof(kIndexMagic));
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * sizeof(IndexEntry));
+    return file.commit();
+}
+
+bool AudioFingerprintIndex::mergeSegments(int first)
+{
+    // 将 first 之后的段多路归并为一个新段
+    QString name = QString("seg_%1.bin").arg(nextSegmentId++);
+    QSaveFile out(dirPath + "/" + name);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QVector<const IndexEntry *> entries;
+    QVector<quint64> counts;
+    QVector<quint64> positions;
+    quint64 total = 0;
+    for (int i = first; i < segments.segments().size(); ++i) {
+        const IndexEntry *segmentData;
+        counts.append(segmentEntries(segments.segments()[i], &segmentData));
+        entries.append(segmentData);
+        positions.append(0);
+        total += counts.last();
+    }
+    out.write(kIndexMagic, sizeof(kIndexMagic));
+    out.write(reinterpret_cast<const char *>(&total), sizeof(total));
+
+    QVector<IndexEntry> buffer;
+    buffer.reserve(65536);
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char *>(buffer.constData()), buffer.size() * sizeof(IndexEntry));
+        buffer.clear();
+    };
+
+    EntryLess less;
+    for (quint64 n = 0; n < total; ++n) {
+        int best = -1;
+        for (int k = 0; k < positions.size(); ++k) {
+            if (positions[k] < counts[k] &&
+                (best < 0 || less(entries[k][positions[k]], entries[best][positions[best]]))) {
+                best = k;
+            }
+        }
+        buffer.append(entries[best][positions[best]++]);
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+        }
+    }
+    flush();
+
+    if (!out.commit()) {
+        return false;
+    }
+
+    // records.json 指向新段之后才删除旧段
+    return segments.commit(first, name, [this](const QStringList &names) { return saveRecords(names); });
+}
+
+QVector<quint32> AudioFingerprintIndex::loadRecordFingerprint(qint32 recordId) const
+{
+    QVector<quint32> result;
+
+    QFile file(recordPath(recordId, ".fp"));
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray data = file.readAll();
+        file.close();
+
+        result.resize(data.size() / static_cast<int>(sizeof(quint32)));
+        memcpy(result.data(), data.constData(), result.size() * sizeof(quint32));
+    }
+    return result;
+}
+
+QVector<SubtitleCue> AudioFingerprintIndex::loadRecordCues(qint32 recordId, bool *wordTimings) const
+{
+    QVector<SubtitleCue> result;
+    *wordTimings = false;
+
+    QFile file(recordPath(recordId, ".json"));
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        file.close();
+
+        result = cuesFromJson(doc.object()["cues"].toArray());
+        *wordTimings = doc.object()["wordTimings"].toBool();
+    }
+    return result;
+}
+
+QString AudioFingerprintIndex::recordPath(qint32 recordId, const QString &suffix) const
+{
+    return dirPath + "/rec_" + QString::number(recordId) + suffix;
+}
@@ -0,0 +1,95 @@
+#ifndef AUDIOFINGERPRINT_H
+#define AUDIOFINGERPRINT_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <QFile>
+#include <QMutex>
+#include <QAtomicInt>
+#include "subtitlecue.h"
+#include "segmentset.h"
+
+// 与已转写录音重复的一段音频
+struct FingerprintMatch {
+    qint64 startMs;             // 在当前音频中的起始时间
+    qint64 endMs;               // 在当前音频中的结束时间
+    qint32 recordId;            // 命中的历史录音，0 表示同一文件的上一次转写
+    QVector<SubtitleCue> cues;  // 已平移到当前音频时间轴的字幕
+};
+
+// 基于16kHz单声道PCM的片段级声学指纹索引
+//
+// 每32ms生成一个32位子指纹(33个对数频带能量差的符号)，
+// 每加入一段录音生成一个按哈希排序的新段，查询时通过内存映射在各段中二分查找。
+// 最新的几个段大小相近时合并为一个段，每个条目只被重写对数次。
+// 目录结构:
+//   seg_<n>.bin    排序后的 (哈希, 录音ID, 帧号) 表
+//   records.json   录音ID分配、来源文件及段列表，先于删除旧段整体替换
+//   rec_<id>.fp    该录音完整的子指纹序列
+//   rec_<id>.json  该录音的字幕
+class AudioFingerprintIndex
+{
+public:
+    explicit AudioFingerprintIndex(const QString &dirPath);
+
+    // 每个子指纹对应的时长(毫秒)
+    static const int kFrameMs = 32;
+
+    // 计算WAV文件(16kHz, 单声道, 16位PCM)的子指纹序列，失败或取消时返回空
+    // weakBits 不为空时同时输出每帧最不可靠的几位(掩码)，供 lookup 使用
+    static QVector<quint32> fingerprintWav(const QString &wavPath, const QAtomicInt *cancel = nullptr,
+                                           QVector<quint32> *weakBits = nullptr);
+
+    // 查找与历史录音重复、且带有字幕的片段，结果按时间排序且互不重叠
+    // 每帧只查找原值和翻转 weakBits 中各位组合后的值，weakBits 为空时只查找原值
+    // requireWords 为 true 时跳过转写时没有记录逐词时间的录音
+    QVector<FingerprintMatch> lookup(const QVector<quint32> &fingerprint, const QVector<quint32> &weakBits,
+                                     bool requireWords, const QAtomicInt *cancel = nullptr);
+
+    // 将当前音频与同一文件上一次转写时的子指纹对齐，返回未变化、可沿用原字幕的片段，取消时返回空
+    static QVector<FingerprintMatch> alignRecording(const QVector<quint32> &fingerprint,
+                                                    const QVector<quint32> &previous,
+                                                    const QVector<SubtitleCue> &previousCues,
+                                                    const QAtomicInt *cancel = nullptr);
+
+    // 读写与字幕文件放在一起的转写状态(子指纹 + 字幕)，用于增量转写
+    // wordTimings 记录转写时是否输出了逐词时间，没有记录的旧状态视为没有
+    static bool loadRecordingState(const QString &path, QVector<quint32> *fingerprint, QVector<SubtitleCue> *cues,
+                                   bool *wordTimings);
+    static bool saveRecordingState(const QString &path, const QVector<quint32> &fingerprint, const QVector<SubtitleCue> &cues,
+                                   bool wordTimings);
+
+    // 将一段已转写的录音加入索引，skipSpans 中的区间(毫秒)不再重复建立哈希
+    bool addRecording(const QString &sourcePath,
+                      const QVector<quint32> &fingerprint,
+                      const QVector<SubtitleCue> &cues,
+                      const QVector<QPair<qint64, qint64>> &skipSpans,
+                      bool wordTimings);
+
+private:
+    struct IndexEntry {
+        quint32 hash;
+        quint32 recordId;
+        quint32 frame;
+    };
+
+    QString dirPath;
+    QMutex mutex;
+    QHash<qint32, QString> sources;     // 录音ID到来源文件
+    SegmentSet segments;
+    qint32 nextRecordId;
+    int nextSegmentId;
+
+    bool saveRecords(const QStringList &segmentNames);
+    static quint64 segmentEntries(const SegmentSet::Segment &segment, const IndexEntry **entries);
+    bool writeSegment(const QString &name, const QVector<IndexEntry> &entries);
+    bool mergeSegments(int first);
+    QVector<quint32> loadRecordFingerprint(qint32 recordId) const;
+    QVector<SubtitleCue> loadRecordCues(qint32 recordId, bool *wordTimings) const;
+    QString recordPath(qint32 recordId, const QString &suffix) const;
+};
+
+#endif // AUDIOFINGERPRINT_H
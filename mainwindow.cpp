@@ -1,9 +1,86 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QDir>
+#include <QtConcurrent>
+#include <QApplication>
+#include <QClipboard>
+#include <QDesktopServices>
+#include <QElapsedTimer>
+#include <QUrl>
+#include <QVBoxLayout>
+#include <QVideoWidget>
 
-// 字幕序号的静态变量定义
-static int subtitleNumber = 1;
+// 短于该时长的空隙不再单独识别(毫秒)
+static const qint64 kMinRecognizeMs = 1000;
+
+// 将毫秒格式化为SRT时间戳 HH:MM:SS,mmm
+static QString formatSrtTime(qint64 ms)
+{
+    return QString("%1:%2:%3,%4")
+        .arg(ms / 3600000, 2, 10, QChar('0'))
+        .arg((ms % 3600000) / 60000, 2, 10, QChar('0'))
+        .arg((ms % 60000) / 1000, 2, 10, QChar('0'))
+        .arg(ms % 1000, 3, 10, QChar('0'));
+}
+
+// 计算音频指纹，与上一次转写对齐并在索引中查找重复片段，生成识别计划(在后台线程执行)
+// index 为空时不查找重复片段，previousFingerprint 为空时不做增量比对，requireWords 时不复用没有逐词时间的字幕
+static RecognitionPlan buildRecognitionPlan(AudioFingerprintIndex *index, const QString &wavPath,
+                                            bool computeFingerprint, bool requireWords,
+                                            const QVector<quint32> &previousFingerprint,
+                                            const QVector<SubtitleCue> &previousCues,
+                                            const QAtomicInt *cancel)
+{
+    RecognitionPlan plan;
+    plan.wavPath = wavPath;
+    
+    QVector<quint32> weakBits;
+    if (computeFingerprint) {
+        plan.fingerprint = AudioFingerprintIndex::fingerprintWav(wavPath, cancel, &weakBits);
+    }
+    
+    QVector<FingerprintMatch> matches;
+    if (!plan.fingerprint.isEmpty()) {
+        // 未变化的部分沿用上一次的字幕
+        matches = AudioFingerprintIndex::alignRecording(plan.fingerprint, previousFingerprint, previousCues, cancel);
+        
+        // 其余部分再查找与其他录音重复的片段
+        if (index != nullptr) {
+            for (const FingerprintMatch &match : index->lookup(plan.fingerprint, weakBits, requireWords, cancel)) {
+                bool overlapped = false;
+                for (const FingerprintMatch &existing : matches) {
+                    if (match.startMs < existing.endMs && existing.startMs < match.endMs) {
+                        overlapped = true;
+                        break;
+                    }
+                }
+                if (!overlapped) {
+                    matches.append(match);
+                }
+            }
+            std::sort(matches.begin(), matches.end(), [](const FingerprintMatch &a, const FingerprintMatch &b) {
+                return a.startMs < b.startMs;
+            });
+        }
+    }
+    
+    // 重复片段之间的空隙交给wav2srt识别
+    qint64 cursor = 0;
+    for (const FingerprintMatch &match : matches) {
+        if (match.startMs - cursor >= kMinRecognizeMs) {
+            plan.segments.append({ cursor, match.startMs, false, QVector<SubtitleCue>() });
+        }
+        plan.segments.append({ match.startMs, match.endMs, true, match.cues });
+        cursor = match.endMs;
+    }
+    
+    qint64 audioMs = qint64(plan.fingerprint.size()) * AudioFingerprintIndex::kFrameMs;
+    if (matches.isEmpty() || audioMs - cursor >= kMinRecognizeMs) {
+        plan.segments.append({ cursor, -1, false, QVector<SubtitleCue>() });
+    }
+    
+    return plan;
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -22,6 +99,25 @@ MainWindow::MainWindow(QWidget *parent)
     // 应用配置
     ui->srtCheckBox->setChecked(config.srtEnabled);
     ui->txtCheckBox->setChecked(config.txtEnabled);
+    ui->vttCheckBox->setChecked(config.vttEnabled);
+    ui->assCheckBox->setChecked(config.assEnabled);
+    ui->jsonCheckBox->setChecked(config.jsonEnabled);
+    ui->dedupCheckBox->setChecked(config.dedupEnabled);
+    ui->incrementalCheckBox->setChecked(config.incrementalEnabled);
+    
+    // 重复片段指纹索引
+    fingerprintIndex = new AudioFingerprintIndex(getAppPath() + "fingerprint");
+    planWatcher = nullptr;
+    indexPool.setMaxThreadCount(1);
+    segmentIndex = 0;
+    segmentCueStart = 0;
+    
+    // 字幕检索索引
+    transcriptIndex = new TranscriptIndex(getAppPath() + "transcripts");
+    ui->searchResultList->setVisible(false);
+    previewDialog = nullptr;
+    previewPlayer = nullptr;
+    previewSeekMs = -1;
     
     ffmpegProcess = new QProcess(this);
     wav2srtProcess = new QProcess(this);
@@ -45,9 +141,19 @@ MainWindow::MainWindow(QWidget *parent)
     connect(getVideoDurationProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &MainWindow::getVideoDurationFinished);
     
+    // 外部程序无法启动时不会有 finished 信号
+    connect(ffmpegProcess, &QProcess::errorOccurred, this, &MainWindow::processErrorOccurred);
+    connect(wav2srtProcess, &QProcess::errorOccurred, this, &MainWindow::processErrorOccurred);
+    connect(getVideoDurationProcess, &QProcess::errorOccurred, this, &MainWindow::processErrorOccurred);
+    
     // 连接配置变化信号
     connect(ui->srtCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_srtCheckBox_stateChanged(int)));
     connect(ui->txtCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_txtCheckBox_stateChanged(int)));
+    connect(ui->vttCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_vttCheckBox_stateChanged(int)));
+    connect(ui->assCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_assCheckBox_stateChanged(int)));
+    connect(ui->jsonCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_jsonCheckBox_stateChanged(int)));
+    connect(ui->dedupCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_dedupCheckBox_stateChanged(int)));
+    connect(ui->incrementalCheckBox, SIGNAL(stateChanged(int)), this, SLOT(on_incrementalCheckBox_stateChanged(int)));
     
     // 初始化UI状态
     ui->startButton->setEnabled(false);
@@ -67,6 +173,15 @@ MainWindow::~MainWindow()
     // 保存配置
     saveConfig();
     
+    // 等待后台任务结束，已取消的比对仍可能在访问指纹索引
+    if (planCancel) {
+        *planCancel = 1;
+    }
+    QThreadPool::globalInstance()->waitForDone();
+    indexPool.waitForDone();
+    delete fingerprintIndex;
+    delete transcriptIndex;
+    
     delete ui;
 }
 
@@ -77,7 +192,15 @@ void MainWindow::loadConfig()
     // 设置默认配置
     config.srtEnabled = true;
     config.txtEnabled = true;
+    config.vttEnabled = false;
+    config.assEnabled = false;
+    config.jsonEnabled = false;
+    config.dedupEnabled = true;
+    config.incrementalEnabled = true;
     config.lastVideoDir = "";
+    config.ffmpegPath = "ffmpeg-win32-x64.exe";
+    config.wav2srtPath = "wav2srt.exe";
+    config.modelPath = "ggml-base.bin";
     
     if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QByteArray data = file.readAll();
@@ -93,8 +216,32 @@ void MainWindow::loadConfig()
             if (obj.contains("txtEnabled") && obj["txtEnabled"].isBool())
                 config.txtEnabled = obj["txtEnabled"].toBool();
                 
+            if (obj.contains("vttEnabled") && obj["vttEnabled"].isBool())
+                config.vttEnabled = obj["vttEnabled"].toBool();
+                
+            if (obj.contains("assEnabled") && obj["assEnabled"].isBool())
+                config.assEnabled = obj["assEnabled"].toBool();
+                
+            if (obj.contains("jsonEnabled") && obj["jsonEnabled"].isBool())
+                config.jsonEnabled = obj["jsonEnabled"].toBool();
+                
+            if (obj.contains("dedupEnabled") && obj["dedupEnabled"].isBool())
+                config.dedupEnabled = obj["dedupEnabled"].toBool();
+                
+            if (obj.contains("incrementalEnabled") && obj["incrementalEnabled"].isBool())
+                config.incrementalEnabled = obj["incrementalEnabled"].toBool();
+                
             if (obj.contains("lastVideoDir") && obj["lastVideoDir"].isString())
                 config.lastVideoDir = obj["lastVideoDir"].toString();
+                
+            if (obj.contains("ffmpegPath") && obj["ffmpegPath"].isString())
+                config.ffmpegPath = obj["ffmpegPath"].toString();
+                
+            if (obj.contains("wav2srtPath") && obj["wav2srtPath"].isString())
+                config.wav2srtPath = obj["wav2srtPath"].toString();
+                
+            if (obj.contains("modelPath") && obj["modelPath"].isString())
+                config.modelPath = obj["modelPath"].toString();
         }
     }
 }
@@ -104,6 +251,14 @@ void MainWindow::saveConfig()
     QJsonObject obj;
     obj["srtEnabled"] = ui->srtCheckBox->isChecked();
     obj["txtEnabled"] = ui->txtCheckBox->isChecked();
+    obj["vttEnabled"] = ui->vttCheckBox->isChecked();
+    obj["assEnabled"] = ui->assCheckBox->isChecked();
+    obj["jsonEnabled"] = ui->jsonCheckBox->isChecked();
+    obj["dedupEnabled"] = ui->dedupCheckBox->isChecked();
+    obj["incrementalEnabled"] = ui->incrementalCheckBox->isChecked();
+    obj["ffmpegPath"] = config.ffmpegPath;
+    obj["wav2srtPath"] = config.wav2srtPath;
+    obj["modelPath"] = config.modelPath;
     
     // 保存最后选择的视频目录
     if (!videoFilePath.isEmpty()) {
@@ -133,6 +288,138 @@ void MainWindow::on_txtCheckBox_stateChanged(int state)
     saveConfig();
 }
 
+void MainWindow::on_vttCheckBox_stateChanged(int state)
+{
+    Q_UNUSED(state);
+    saveConfig();
+}
+
+void MainWindow::on_assCheckBox_stateChanged(int state)
+{
+    Q_UNUSED(state);
+    saveConfig();
+}
+
+void MainWindow::on_jsonCheckBox_stateChanged(int state)
+{
+    Q_UNUSED(state);
+    saveConfig();
+}
+
+void MainWindow::on_dedupCheckBox_stateChanged(int state)
+{
+    Q_UNUSED(state);
+    saveConfig();
+}
+
+void MainWindow::on_incrementalCheckBox_stateChanged(int state)
+{
+    Q_UNUSED(state);
+    saveConfig();
+}
+
+void MainWindow::on_searchButton_clicked()
+{
+    QString query = ui->searchLineEdit->text().trimmed();
+    ui->searchResultList->clear();
+    
+    if (query.isEmpty()) {
+        ui->searchResultList->setVisible(false);
+    previewDialog = nullptr;
+    previewPlayer = nullptr;
+    previewSeekMs = -1;
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    QVector<TranscriptHit> hits = transcriptIndex->search(query);
+    
+    for (const TranscriptHit &hit : hits) {
+        QListWidgetItem *item = new QListWidgetItem(QString("[%1] %2  %3").arg(
+            formatDuration(hit.startMs),
+            QFileInfo(hit.filePath).fileName(),
+            hit.text), ui->searchResultList);
+        item->setToolTip(hit.filePath);
+        item->setData(Qt::UserRole, hit.filePath);
+        item->setData(Qt::UserRole + 1, hit.startMs);
+    }
+    
+    ui->searchResultList->setVisible(true);
+    ui->statusBar->showMessage(QString("找到 %1 条字幕，耗时 %2 毫秒").arg(hits.size()).arg(timer.elapsed()));
+}
+
+void MainWindow::on_searchLineEdit_returnPressed()
+{
+    on_searchButton_clicked();
+}
+
+void MainWindow::on_searchResultList_itemDoubleClicked(QListWidgetItem *item)
+{
+    QString filePath = item->data(Qt::UserRole).toString();
+    qint64 startMs = item->data(Qt::UserRole + 1).toLongLong();
+    
+    if (!QFile::exists(filePath)) {
+        QMessageBox::warning(this, "警告", "文件不存在: " + filePath);
+        return;
+    }
+    
+    playPreview(filePath, startMs);
+}
+
+void MainWindow::playPreview(const QString &filePath, qint64 startMs)
+{
+    if (previewPlayer == nullptr) {
+        previewDialog = new QDialog(this);
+        previewDialog->resize(640, 400);
+        QVBoxLayout *layout = new QVBoxLayout(previewDialog);
+        layout->setContentsMargins(0, 0, 0, 0);
+        QVideoWidget *videoWidget = new QVideoWidget(previewDialog);
+        layout->addWidget(videoWidget);
+        
+        previewPlayer = new QMediaPlayer(this);
+        previewPlayer->setVideoOutput(videoWidget);
+        connect(previewDialog, &QDialog::finished, previewPlayer, &QMediaPlayer::stop);
+        
+        // 媒体加载完成前设置的位置会被忽略
+        connect(previewPlayer, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+            if (previewSeekMs >= 0 && (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia)) {
+                previewPlayer->setPosition(previewSeekMs);
+                previewSeekMs = -1;
+            }
+        });
+        
+        // 缺少解码器等无法预览时改用系统默认播放器，它不能指定起始位置，时间点复制到剪贴板
+        connect(previewPlayer, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, [this](QMediaPlayer::Error) {
+            QString timestamp = formatDuration(previewSeekMs >= 0 ? previewSeekMs : previewPlayer->position());
+            QString filePath = previewFilePath;
+            ui->logTextEdit->append("预览播放失败: " + previewPlayer->errorString());
+            previewDialog->hide();
+            previewFilePath.clear();
+            previewSeekMs = -1;
+            
+            QApplication::clipboard()->setText(timestamp);
+            QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
+            ui->statusBar->showMessage("无法预览，已用系统默认播放器打开 " + QFileInfo(filePath).fileName() +
+                                       "，时间点 " + timestamp + " 已复制到剪贴板");
+        });
+    }
+    
+    if (filePath == previewFilePath && previewSeekMs < 0) {
+        previewPlayer->setPosition(startMs);
+    } else {
+        previewFilePath = filePath;
+        previewSeekMs = startMs;
+        previewPlayer->setMedia(QUrl::fromLocalFile(filePath));
+    }
+    previewPlayer->play();
+    
+    previewDialog->setWindowTitle(QFileInfo(filePath).fileName() + " - " + formatDuration(startMs));
+    previewDialog->show();
+    previewDialog->raise();
+    ui->statusBar->showMessage("正在预览 " + QFileInfo(filePath).fileName() + "，从 " + formatDuration(startMs) + " 开始播放");
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 {
     // 只有不在处理时才接受拖放
@@ -211,7 +498,7 @@ void MainWindow::on_startButton_clicked()
     }
     
     // 检查是否至少选择了一种输出格式
-    if (!ui->srtCheckBox->isChecked() && !ui->txtCheckBox->isChecked()) {
+    if (selectedFormats().isEmpty()) {
         QMessageBox::warning(this, "警告", "请至少选择一种输出格式");
         return;
     }
@@ -231,34 +518,51 @@ void MainWindow::on_startButton_clicked()
     totalDurationMs = 0;
     currentDurationMs = 0;
     
-    // 重置字幕序号
-    subtitleNumber = 1;
+    // 重置识别计划
+    jobFingerprint.clear();
+    recognitionSegments.clear();
+    segmentIndex = 0;
+    jobCues.clear();
+    segmentCueStart = 0;
+    pendingOutput.clear();
     
-    // 生成输出文件名
+    // 生成输出文件名，字幕文件在全部识别完成后一次性写入
     QString basePath = QFileInfo(videoFilePath).absolutePath() + "/" + 
                        QFileInfo(videoFilePath).completeBaseName();
-    outputSrtFilePath = basePath + ".srt";
-    outputTxtFilePath = basePath + ".txt";
+    outputBasePath = basePath;
+    outputStateFilePath = basePath + ".voice2srt.json";
     
-    // 如果需要，先删除之前的文件
-    if (ui->srtCheckBox->isChecked() && QFile::exists(outputSrtFilePath)) {
-        QFile::remove(outputSrtFilePath);
-    }
-    
-    if (ui->txtCheckBox->isChecked() && QFile::exists(outputTxtFilePath)) {
-        QFile::remove(outputTxtFilePath);
+    // 增量转写: 读取上一次转写时保存的音频指纹和字幕
+    previousFingerprint.clear();
+    previousCues.clear();
+    if (ui->incrementalCheckBox->isChecked()) {
+        bool wordTimings = false;
+        AudioFingerprintIndex::loadRecordingState(outputStateFilePath, &previousFingerprint, &previousCues, &wordTimings);
+        
+        // 本次要输出逐词时间而上一次没有记录时，上一次的字幕不能沿用
+        if (ui->jsonCheckBox->isChecked() && !wordTimings) {
+            previousFingerprint.clear();
+            previousCues.clear();
+        }
     }
     
     // 先获取视频时长
     QStringList args;
     args << "-i" << videoFilePath;
-    getVideoDurationProcess->start(getAppPath() + "ffmpeg-win32-x64.exe", args);
+    getVideoDurationProcess->start(toolPath(config.ffmpegPath), args);
 }
 
 void MainWindow::on_stopButton_clicked()
 {
     if (isProcessing) {
         forceStop = true;
+        // 取消重复片段检测，不在界面线程等待，比对结束后由 recognitionPlanReady 删除其临时音频
+        bool planRunning = planWatcher != nullptr;
+        if (planRunning) {
+            *planCancel = 1;
+            planWatcher = nullptr;
+        }
+        
         // 终止所有运行中的进程
         if (getVideoDurationProcess->state() == QProcess::Running) {
             getVideoDurationProcess->kill();
@@ -275,8 +579,12 @@ void MainWindow::on_stopButton_clicked()
             wav2srtProcess->waitForFinished(1000);
         }
         forceStop = false;
-        // 删除临时文件
-        QFile::remove(tempWavFilePath);
+        // 删除临时文件，正在比对的音频在比对结束后删除
+        if (!planRunning) {
+            QFile::remove(tempWavFilePath);
+        }
+        QFile::remove(wordTimingBasePath + ".json");
+        QFile::remove(wordTimingBasePath + ".srt");
         
         // 恢复UI状态
         isProcessing = false;
@@ -335,6 +643,7 @@ void MainWindow::getVideoDurationFinished(int exitCode, QProcess::ExitStatus exi
     // 生成临时文件名
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
     tempWavFilePath = QDir::tempPath() + "/temp_audio_" + timestamp + ".wav";
+    wordTimingBasePath = QDir::tempPath() + "/temp_words_" + timestamp;
     
     // 构建FFmpeg命令
     QStringList ffmpegArgs;
@@ -345,7 +654,34 @@ void MainWindow::getVideoDurationFinished(int exitCode, QProcess::ExitStatus exi
     ffmpegArgs << tempWavFilePath;
     
     // 启动FFmpeg进程（使用绝对路径）
-    ffmpegProcess->start(getAppPath() + "ffmpeg-win32-x64.exe", ffmpegArgs);
+    ffmpegProcess->start(toolPath(config.ffmpegPath), ffmpegArgs);
+}
+
+void MainWindow::processErrorOccurred(QProcess::ProcessError error)
+{
+    // 崩溃等其他错误之后仍会收到 finished 信号，由各自的处理函数收尾
+    if (error != QProcess::FailedToStart || !isProcessing) {
+        return;
+    }
+    
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    QString program = QDir::toNativeSeparators(process->program());
+    ui->logTextEdit->append("无法启动 " + program + ": " + process->errorString());
+    
+    // 删除临时文件
+    QFile::remove(tempWavFilePath);
+    QFile::remove(wordTimingBasePath + ".json");
+    QFile::remove(wordTimingBasePath + ".srt");
+    
+    // 恢复UI状态
+    isProcessing = false;
+    setUIEnabled(true);
+    ui->startButton->setEnabled(true);
+    ui->stopButton->setEnabled(false);
+    ui->progressBar->setValue(0);
+    
+    ui->statusLabel->setText("外部程序启动失败");
+    QMessageBox::critical(this, "错误", QString("无法启动 %1\n请检查 config.json 中的程序路径").arg(program));
 }
 
 void MainWindow::ffmpegReadyReadStandardOutput()
@@ -411,19 +747,28 @@ void MainWindow::ffmpegFinished(int exitCode, QProcess::ExitStatus exitStatus)
         // 重置当前处理时长
         currentDurationMs = 0;
         
-        // 构建wav2srt命令
-        QStringList wav2srtArgs;
-        wav2srtArgs << "-f" << tempWavFilePath;
-        wav2srtArgs << "-m" << "ggml-base.bin";
-        wav2srtArgs << "-l" << "zh";
-
-        //解决输出有些时候是繁体中文的问题
-        //  https://blog.csdn.net/abcd51685168/article/details/139904153
-        wav2srtArgs << "--prompt" << "以下是普通话的句子，这是一段会议记录。";
-        wav2srtArgs << "-osrt";
+        bool dedupEnabled = ui->dedupCheckBox->isChecked();
+        bool incrementalEnabled = ui->incrementalCheckBox->isChecked();
+        if (dedupEnabled || incrementalEnabled) {
+            ui->statusLabel->setText("音频提取完成，正在比对音频指纹...");
+        }
         
-        // 启动wav2srt进程（使用绝对路径）
-        wav2srtProcess->start(getAppPath() + "wav2srt.exe", wav2srtArgs);
+        // 在后台线程中生成识别计划
+        AudioFingerprintIndex *index = dedupEnabled ? fingerprintIndex : nullptr;
+        QString wavPath = tempWavFilePath;
+        QVector<quint32> previous = previousFingerprint;
+        QVector<SubtitleCue> cues = previousCues;
+        bool requireWords = ui->jsonCheckBox->isChecked();
+        
+        // 上一个任务停止时仍在运行的比对使用自己的取消标记和监视器，不必等它退出
+        QSharedPointer<QAtomicInt> cancel(new QAtomicInt(0));
+        planCancel = cancel;
+        planWatcher = new QFutureWatcher<RecognitionPlan>(this);
+        connect(planWatcher, &QFutureWatcher<RecognitionPlan>::finished, this, &MainWindow::recognitionPlanReady);
+        planWatcher->setFuture(QtConcurrent::run([=]() {
+            return buildRecognitionPlan(index, wavPath, dedupEnabled || incrementalEnabled, requireWords,
+                                        previous, cues, cancel.data());
+        }));
     } else if (forceStop == false) {
         // 恢复UI状态
         isProcessing = false;
@@ -436,125 +781,115 @@ void MainWindow::ffmpegFinished(int exitCode, QProcess::ExitStatus exitStatus)
     }
 }
 
-void MainWindow::wav2srtReadyReadStandardOutput()
+void MainWindow::recognitionPlanReady()
 {
-    QString output = wav2srtProcess->readAllStandardOutput();
-    ui->logTextEdit->append(output);
+    auto *watcher = static_cast<QFutureWatcher<RecognitionPlan> *>(sender());
+    watcher->deleteLater();
     
-    // 正则表达式匹配时间戳格式 [HH:MM:SS.XXX --> HH:MM:SS.XXX]
-    QRegularExpression timeStampRegex("\\[(\\d\\d):(\\d\\d):(\\d\\d)\\.(\\d\\d\\d) --> (\\d\\d):(\\d\\d):(\\d\\d)\\.(\\d\\d\\d)\\]");
+    // 已被停止的任务留下的比对，删除其临时音频
+    RecognitionPlan plan = watcher->result();
+    if (watcher != planWatcher) {
+        if (plan.wavPath != tempWavFilePath || !isProcessing) {
+            QFile::remove(plan.wavPath);
+        }
+        return;
+    }
+    planWatcher = nullptr;
     
-    // 如果需要SRT文件，转换为标准格式
-    if (ui->srtCheckBox->isChecked()) {
-        QFile srtFile(outputSrtFilePath);
-        if (srtFile.open(QIODevice::Append | QIODevice::Text)) {
-            QTextStream out(&srtFile);
-            
-            // 解析wav2srt输出，转换为标准SRT格式
-            QStringList lines = output.split('\n');
-            QString currentSubtitleText;
-            bool isInSubtitle = false;
-            
-            for (const QString &line : lines) {
-                QString trimmedLine = line.trimmed();
-                
-                // 跳过空行
-                if (trimmedLine.isEmpty()) {
-                    continue;
-                }
-                
-                // 检查是否为时间戳行
-                QRegularExpressionMatch match = timeStampRegex.match(trimmedLine);
-                if (match.hasMatch()) {
-                    // 如果有当前字幕，先输出
-                    if (isInSubtitle) {
-                        out << subtitleNumber << "\n";
-                        out << currentSubtitleText << "\n\n";
-                        subtitleNumber++;
-                    }
-                    
-                    // 开始新的字幕
-                    isInSubtitle = true;
-                    
-                    // 提取时间戳并转换为标准格式
-                    QString startTime = match.captured(1) + ":" + match.captured(2) + ":" + match.captured(3) + "," + match.captured(4);
-                    QString endTime = match.captured(5) + ":" + match.captured(6) + ":" + match.captured(7) + "," + match.captured(8);
-                    
-                    // 提取时间戳后的文本
-                    int textStart = trimmedLine.indexOf("]") + 1;
-                    QString subtitleText = trimmedLine.mid(textStart).trimmed();
-                    
-                    // 构建标准SRT时间行
-                    currentSubtitleText = startTime + " --> " + endTime + "\n";
-                    
-                    // 添加字幕文本（如果有）
-                    if (!subtitleText.isEmpty()) {
-                        currentSubtitleText += subtitleText + "\n";
-                    }
-                    
-                    continue;
-                }
-                
-                // 处理可能的多行字幕文本
-                if (isInSubtitle && !trimmedLine.isEmpty()) {
-                    currentSubtitleText += trimmedLine + "\n";
-                }
-            }
-            
-            // 输出最后一个字幕
-            if (isInSubtitle) {
-                out << subtitleNumber << "\n";
-                out << currentSubtitleText << "\n";
-                subtitleNumber++;
-            }
-            
-            srtFile.close();
+    jobFingerprint = plan.fingerprint;
+    recognitionSegments = plan.segments;
+    segmentIndex = 0;
+    
+    int reusedCount = 0;
+    for (const RecognitionSegment &segment : recognitionSegments) {
+        if (segment.reuse) {
+            reusedCount++;
         }
     }
+    if (reusedCount > 0) {
+        ui->logTextEdit->append(QString("共有 %1 段音频与已有字幕一致，直接复用，只识别其余部分").arg(reusedCount));
+    }
     
-    // 如果需要TXT文件，直接从输出中提取文本
-    if (ui->txtCheckBox->isChecked()) {
-        QFile txtFile(outputTxtFilePath);
-        if (txtFile.open(QIODevice::Append | QIODevice::Text)) {
-            QTextStream out(&txtFile);
-            
-            // 解析wav2srt输出，提取纯文本
-            QStringList lines = output.split('\n');
-            bool isFirstLine = true;
-            
-            for (const QString &line : lines) {
-                QString trimmedLine = line.trimmed();
-                
-                // 跳过空行
-                if (trimmedLine.isEmpty()) {
-                    continue;
-                }
-                
-                // 检查是否为时间戳行
-                if (timeStampRegex.match(trimmedLine).hasMatch()) {
-                    // 提取时间戳后的文本
-                    int textStart = trimmedLine.indexOf("]") + 1;
-                    QString subtitleText = trimmedLine.mid(textStart).trimmed();
-                    
-                    if (!subtitleText.isEmpty()) {
-                        if (!isFirstLine) {
-                            out << "\n"; // 字幕块之间添加空行分隔
-                        }
-                        out << subtitleText << "\n";
-                        isFirstLine = false;
-                    }
-                    
-                    continue;
-                }
-                
-                // 处理可能的多行字幕文本
-                if (!isFirstLine && !trimmedLine.isEmpty()) {
-                    out << trimmedLine << "\n";
-                }
-            }
-            
-            txtFile.close();
+    ui->statusLabel->setText("正在识别字幕...");
+    startNextSegment();
+}
+
+void MainWindow::startNextSegment()
+{
+    // 复用片段直接输出历史字幕
+    while (segmentIndex < recognitionSegments.size() && recognitionSegments[segmentIndex].reuse) {
+        const RecognitionSegment &segment = recognitionSegments[segmentIndex];
+        ui->logTextEdit->append(QString("复用字幕: %1 - %2").arg(formatSrtTime(segment.startMs), formatSrtTime(segment.endMs)));
+        jobCues += segment.cues;
+        
+        if (totalDurationMs > 0) {
+            ui->progressBar->setValue(50 + qMin(50, static_cast<int>((segment.endMs * 50) / totalDurationMs)));
         }
+        segmentIndex++;
+    }
+    
+    if (segmentIndex >= recognitionSegments.size()) {
+        finishRecognition(true);
+        return;
+    }
+    
+    const RecognitionSegment &segment = recognitionSegments[segmentIndex];
+    segmentCueStart = jobCues.size();
+    pendingOutput.clear();
+    
+    // 构建wav2srt命令
+    QStringList wav2srtArgs;
+    wav2srtArgs << "-f" << tempWavFilePath;
+    wav2srtArgs << "-m" << config.modelPath;
+    wav2srtArgs << "-l" << "zh";
+
+    //解决输出有些时候是繁体中文的问题
+    //  https://blog.csdn.net/abcd51685168/article/details/139904153
+    wav2srtArgs << "--prompt" << "以下是普通话的句子，这是一段会议记录。";
+    wav2srtArgs << "-osrt";
+    
+    // 只识别计划中的区间，输出的时间戳仍是相对整个音频的
+    if (segment.startMs > 0) {
+        wav2srtArgs << "-ot" << QString::number(segment.startMs);
+    }
+    if (segment.endMs >= 0) {
+        wav2srtArgs << "-d" << QString::number(segment.endMs - segment.startMs);
+    }
+    
+    // 需要逐词时间时，另外输出包含每个词时间和概率的JSON
+    if (ui->jsonCheckBox->isChecked()) {
+        wav2srtArgs << "-ojf" << "-of" << wordTimingBasePath;
+    }
+    
+    // 启动wav2srt进程（使用绝对路径）
+    wav2srtProcess->start(toolPath(config.wav2srtPath), wav2srtArgs);
+}
+
+QStringList MainWindow::selectedFormats() const
+{
+    QStringList formats;
+    if (ui->srtCheckBox->isChecked()) formats << "srt";
+    if (ui->txtCheckBox->isChecked()) formats << "txt";
+    if (ui->vttCheckBox->isChecked()) formats << "vtt";
+    if (ui->assCheckBox->isChecked()) formats << "ass";
+    if (ui->jsonCheckBox->isChecked()) formats << "json";
+    return formats;
+}
+
+void MainWindow::wav2srtReadyReadStandardOutput()
+{
+    QByteArray data = wav2srtProcess->readAllStandardOutput();
+    QString output = QString::fromUtf8(data);
+    ui->logTextEdit->append(output);
+    
+    // 输出可能在任意位置被截断，只解析完整的行，剩余部分留到下次
+    pendingOutput += data;
+    int lineEnd = pendingOutput.lastIndexOf('\n');
+    if (lineEnd >= 0) {
+        for (const QByteArray &line : pendingOutput.left(lineEnd).split('\n')) {
+            WhisperOutput::parseLine(QString::fromUtf8(line), &jobCues, segmentCueStart);
+        }
+        pendingOutput.remove(0, lineEnd + 1);
     }
     
     // 尝试从wav2srt输出中提取当前处理时间
@@ -592,6 +927,39 @@ void MainWindow::wav2srtReadyReadStandardError()
 }
 
 void MainWindow::wav2srtFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+        // 读完剩余输出，最后一行可能没有换行符
+        if (wav2srtProcess->bytesAvailable() > 0) {
+            wav2srtReadyReadStandardOutput();
+        }
+        WhisperOutput::parseLine(QString::fromUtf8(pendingOutput), &jobCues, segmentCueStart);
+        pendingOutput.clear();
+        
+        if (ui->jsonCheckBox->isChecked()) {
+            QFile jsonFile(wordTimingBasePath + ".json");
+            QString jsonError;
+            if (jsonFile.open(QIODevice::ReadOnly) &&
+                !WhisperOutput::attachWordTimings(jsonFile.readAll(), &jobCues, segmentCueStart, &jsonError)) {
+                ui->logTextEdit->append("无法读取逐词时间: " + jsonError);
+            }
+            jsonFile.close();
+        }
+        QFile::remove(wordTimingBasePath + ".json");
+        QFile::remove(wordTimingBasePath + ".srt");
+        
+        // 继续识别计划中的下一段
+        segmentIndex++;
+        startNextSegment();
+    } else {
+        pendingOutput.clear();
+        QFile::remove(wordTimingBasePath + ".json");
+        QFile::remove(wordTimingBasePath + ".srt");
+        finishRecognition(false);
+    }
+}
+
+void MainWindow::finishRecognition(bool success)
 {
     // 删除临时WAV文件
     QFile::remove(tempWavFilePath);
@@ -602,32 +970,61 @@ void MainWindow::wav2srtFinished(int exitCode, QProcess::ExitStatus exitStatus)
     ui->startButton->setEnabled(true);
     ui->stopButton->setEnabled(false);
     
-    if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-        ui->statusLabel->setText("字幕提取完成");
-        ui->progressBar->setValue(100);
+    if (success) {
+        // 所有格式一次生成，写入临时文件后再替换，不会留下写了一半的字幕文件
+        SubtitleOutput output(outputBasePath, selectedFormats());
+        QStringList writtenFiles;
+        QString outputError;
+        bool written = output.write(jobCues, &writtenFiles, &outputError);
         
-        // 显示成功消息
-        QString successMsg = "字幕提取完成";
-        bool hasSrt = ui->srtCheckBox->isChecked();
-        bool hasTxt = ui->txtCheckBox->isChecked();
-        
-        // 检查文件是否实际生成
-        if (hasSrt && !QFile::exists(outputSrtFilePath)) {
-            successMsg += "\n警告: SRT文件未生成";
-            hasSrt = false;
+        // 将本次字幕加入检索索引
+        {
+            TranscriptIndex *index = transcriptIndex;
+            QString source = videoFilePath;
+            QVector<SubtitleCue> cues = jobCues;
+            
+            QtConcurrent::run(&indexPool, [=]() {
+                index->addTranscript(source, cues);
+            });
         }
         
-        if (hasTxt && !QFile::exists(outputTxtFilePath)) {
-            successMsg += "\n警告: TXT文件未生成";
-            hasTxt = false;
+        // 保存本次的音频指纹和字幕，供下次增量转写
+        if (ui->incrementalCheckBox->isChecked() && !jobFingerprint.isEmpty()) {
+            AudioFingerprintIndex::saveRecordingState(outputStateFilePath, jobFingerprint, jobCues,
+                                                     ui->jsonCheckBox->isChecked());
         }
         
-        if (hasSrt) {
-            successMsg += "\nSRT文件已保存到: " + outputSrtFilePath;
+        // 将本次结果加入指纹索引，供以后复用
+        if (ui->dedupCheckBox->isChecked() && !jobFingerprint.isEmpty()) {
+            QVector<QPair<qint64, qint64>> reusedSpans;
+            for (const RecognitionSegment &segment : recognitionSegments) {
+                if (segment.reuse) {
+                    reusedSpans.append(qMakePair(segment.startMs, segment.endMs));
+                }
+            }
+            
+            AudioFingerprintIndex *index = fingerprintIndex;
+            QString source = videoFilePath;
+            QVector<quint32> fingerprint = jobFingerprint;
+            QVector<SubtitleCue> cues = jobCues;
+            bool wordTimings = ui->jsonCheckBox->isChecked();
+            
+            QtConcurrent::run(&indexPool, [=]() {
+                index->addRecording(source, fingerprint, cues, reusedSpans, wordTimings);
+            });
         }
         
-        if (hasTxt) {
-            successMsg += "\nTXT文件已保存到: " + outputTxtFilePath;
+        ui->statusLabel->setText("字幕提取完成");
+        ui->progressBar->setValue(100);
+        
+        // 显示成功消息
+        QString successMsg = "字幕提取完成";
+        if (written) {
+            for (const QString &filePath : writtenFiles) {
+                successMsg += "\n已保存到: " + filePath;
+            }
+        } else {
+            successMsg += "\n警告: 字幕文件写入失败: " + outputError;
         }
         
         QMessageBox::information(this, "成功", successMsg);
@@ -642,10 +1039,20 @@ QString MainWindow::getAppPath() const
     return QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/";
 }
 
+QString MainWindow::toolPath(const QString &path) const
+{
+    return QDir(getAppPath()).absoluteFilePath(path);
+}
+
 void MainWindow::setUIEnabled(bool enabled)
 {
     ui->selectVideoButton->setEnabled(enabled);
     ui->videoPathLineEdit->setEnabled(enabled);
     ui->srtCheckBox->setEnabled(enabled);
     ui->txtCheckBox->setEnabled(enabled);
+    ui->vttCheckBox->setEnabled(enabled);
+    ui->assCheckBox->setEnabled(enabled);
+    ui->jsonCheckBox->setEnabled(enabled);
+    ui->dedupCheckBox->setEnabled(enabled);
+    ui->incrementalCheckBox->setEnabled(enabled);
 }    
@@ -14,11 +14,37 @@
 #include <QRegularExpression>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QListWidgetItem>
+#include <QMediaPlayer>
+#include <QDialog>
+#include "subtitlecue.h"
+#include "audiofingerprint.h"
+#include "transcriptindex.h"
+#include "subtitlewriter.h"
+#include "whisperoutput.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
+// 识别计划中的一段: 复用历史字幕，或交给wav2srt识别
+struct RecognitionSegment {
+    qint64 startMs;
+    qint64 endMs;               // -1 表示到音频结尾
+    bool reuse;
+    QVector<SubtitleCue> cues;  // reuse 为 true 时要输出的字幕
+};
+
+struct RecognitionPlan {
+    QString wavPath;            // 计划对应的临时音频
+    QVector<quint32> fingerprint;
+    QVector<RecognitionSegment> segments;
+};
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -44,10 +70,22 @@ private slots:
     void getVideoDurationReadyReadStandardOutput();
     void getVideoDurationReadyReadStandardError();
     void getVideoDurationFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void processErrorOccurred(QProcess::ProcessError error);
+    void recognitionPlanReady();
     
     // 配置改变时保存配置
     void on_srtCheckBox_stateChanged(int state);
     void on_txtCheckBox_stateChanged(int state);
+    void on_vttCheckBox_stateChanged(int state);
+    void on_assCheckBox_stateChanged(int state);
+    void on_jsonCheckBox_stateChanged(int state);
+    void on_dedupCheckBox_stateChanged(int state);
+    void on_incrementalCheckBox_stateChanged(int state);
+    
+    // 字幕搜索
+    void on_searchButton_clicked();
+    void on_searchLineEdit_returnPressed();
+    void on_searchResultList_itemDoubleClicked(QListWidgetItem *item);
 
 private:
     Ui::MainWindow *ui;
@@ -56,13 +94,39 @@ private:
     QProcess *getVideoDurationProcess;
     QString videoFilePath;
     QString tempWavFilePath;
-    QString outputSrtFilePath;
-    QString outputTxtFilePath;
+    QString outputBasePath; // 输出文件路径(不含扩展名)
+    QString wordTimingBasePath; // wav2srt逐词时间临时文件路径(不含扩展名)
+    QString outputStateFilePath; // 增量转写状态文件
     qint64 totalDurationMs; // 视频总时长(毫秒)
     qint64 currentDurationMs; // 当前处理时长(毫秒)
     bool isProcessing; // 标记是否正在处理
     bool forceStop; // 正在停止
     
+    // 重复片段检测
+    AudioFingerprintIndex *fingerprintIndex;
+    QFutureWatcher<RecognitionPlan> *planWatcher; // 当前任务的比对，未在比对时为空
+    QSharedPointer<QAtomicInt> planCancel;        // 每次比对单独的取消标记
+    QThreadPool indexPool;                        // 指纹和检索索引的更新按提交顺序在同一个线程中执行
+    QVector<quint32> jobFingerprint;
+    QVector<RecognitionSegment> recognitionSegments;
+    int segmentIndex; // 当前执行到的识别计划序号
+    QVector<SubtitleCue> jobCues; // 本次输出的全部字幕
+    int segmentCueStart; // 当前识别片段的第一条字幕在 jobCues 中的位置
+    QByteArray pendingOutput; // wav2srt尚未读完整的一行输出
+    
+    // 增量转写: 上一次转写的音频指纹和字幕
+    QVector<quint32> previousFingerprint;
+    QVector<SubtitleCue> previousCues;
+    
+    // 字幕检索索引
+    TranscriptIndex *transcriptIndex;
+    
+    // 搜索结果预览
+    QDialog *previewDialog;
+    QMediaPlayer *previewPlayer;
+    QString previewFilePath;
+    qint64 previewSeekMs; // 媒体加载完成后要跳转到的位置，-1 表示没有
+    
     // 配置文件路径
     QString configFilePath;
     
@@ -70,7 +134,15 @@ private:
     struct Config {
         bool srtEnabled;
         bool txtEnabled;
+        bool vttEnabled;
+        bool assEnabled;
+        bool jsonEnabled;
+        bool dedupEnabled;
+        bool incrementalEnabled;
         QString lastVideoDir;
+        QString ffmpegPath;   // 相对路径相对于程序目录
+        QString wav2srtPath;
+        QString modelPath;    // 原样传给wav2srt
     } config;
     
     // 加载和保存配置
@@ -82,6 +154,19 @@ private:
     
     // 获取应用程序路径
     QString getAppPath() const;
+    // 配置中的外部程序路径转为绝对路径
+    QString toolPath(const QString &path) const;
+    
+    // 按识别计划继续处理下一段
+    void startNextSegment();
+    // 全部完成后收尾
+    void finishRecognition(bool success);
+    
+    // 当前勾选的输出格式
+    QStringList selectedFormats() const;
+    
+    // 在预览窗口中从 startMs 开始播放
+    void playPreview(const QString &filePath, qint64 startMs);
     
     // 启用/禁用UI元素
     void setUIEnabled(bool enabled);
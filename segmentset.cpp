@@ -0,0 +1,133 @@
+#include "segmentset.h"
+#include <QDir>
+#include <cstring>
+
+static const int kMergeWidth = 4;               // 最新的4个段处于同一级别时合并
+static const qint64 kLevelBytes = 64 * 1024;    // 小于该大小的段为第0级，每级约为上一级的4倍
+static const int kMaxSegments = 32;             // 超过后不论级别都合并
+
+SegmentSet::SegmentSet(const QString &dirPath, const QByteArray &magic, int headerSize)
+    : dirPath(dirPath)
+    , magic(magic)
+    , headerSize(headerSize)
+{
+}
+
+SegmentSet::~SegmentSet()
+{
+    replace(0, QString());
+}
+
+QStringList SegmentSet::names() const
+{
+    QStringList result;
+    for (const Segment &segment : list) {
+        result.append(segment.name);
+    }
+    return result;
+}
+
+void SegmentSet::append(const QStringList &names)
+{
+    for (const QString &name : names) {
+        Segment segment;
+        segment.name = name;
+        segment.file = new QFile(dirPath + "/" + name);
+        segment.data = nullptr;
+        segment.size = 0;
+
+        if (segment.file->open(QIODevice::ReadOnly)) {
+            segment.size = segment.file->size();
+            if (segment.size >= headerSize) {
+                segment.data = segment.file->map(0, segment.size);
+            }
+        }
+
+        if (segment.data == nullptr || memcmp(segment.data, magic.constData(), magic.size()) != 0) {
+            delete segment.file;
+            continue;
+        }
+        list.append(segment);
+    }
+}
+
+int SegmentSet::level(qint64 size)
+{
+    int result = 0;
+    while (size >= kLevelBytes) {
+        size /= kMergeWidth;
+        result++;
+    }
+    return result;
+}
+
+int SegmentSet::mergeStart() const
+{
+    if (list.size() < kMergeWidth) {
+        return -1;
+    }
+
+    int first = list.size() - kMergeWidth;
+    for (int i = first; i < list.size() - 1; ++i) {
+        if (level(list[i].size) != level(list.last().size)) {
+            return list.size() > kMaxSegments ? first : -1;
+        }
+    }
+    return first;
+}
+
+QStringList SegmentSet::replace(int first, const QString &name)
+{
+    QStringList oldNames;
+    for (int i = first; i < list.size(); ++i) {
+        oldNames.append(list[i].name);
+        delete list[i].file;
+    }
+    list.resize(first);
+
+    if (!name.isEmpty()) {
+        append(QStringList() << name);
+    }
+    return oldNames;
+}
+
+bool SegmentSet::commit(int first, const QString &name, const std::function<bool(const QStringList &)> &saveList,
+                        QMutex *lock)
+{
+    QStringList newNames = names().mid(0, first);
+    if (!name.isEmpty()) {
+        newNames.append(name);
+    }
+    if (!saveList(newNames)) {
+        if (!name.isEmpty()) {
+            QFile::remove(dirPath + "/" + name);
+        }
+        return false;
+    }
+
+    QStringList oldNames;
+    if (lock != nullptr) {
+        QMutexLocker locker(lock);
+        oldNames = replace(first, name);
+    } else {
+        oldNames = replace(first, name);
+    }
+    removeFiles(oldNames);
+    return true;
+}
+
+void SegmentSet::removeFiles(const QStringList &names) const
+{
+    for (const QString &name : names) {
+        QFile::remove(dirPath + "/" + name);
+    }
+}
+
+void SegmentSet::removeUnlisted(const QString &dirPath, const QStringList &patterns, const QStringList &keep)
+{
+    for (const QString &name : QDir(dirPath).entryList(patterns, QDir::Files)) {
+        if (!keep.contains(name)) {
+            QFile::remove(dirPath + "/" + name);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SEGMENTSET_H
+#define SEGMENTSET_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+#include <QMutex>
+#include <functional>
+
+// 一组按加入顺序排列、通过内存映射只读访问的段文件，及其分级合并策略
+//
+// 每次写入生成一个新段，最新的几个段大小相近(处于同一级别)时合并为一个段，
+// 每个条目只被重写对数次；段数过多时不论级别都合并。
+// 段列表保存在使用者自己的清单文件中，新段写好后先保存清单，再替换并删除旧段。
+// 本类不加锁，由使用者保证替换段时没有其他线程在读。
+class SegmentSet
+{
+public:
+    struct Segment {
+        QString name;
+        QFile *file;
+        const uchar *data;
+        qint64 size;
+    };
+
+    // 段文件以 magic 开头，且不短于 headerSize 字节
+    SegmentSet(const QString &dirPath, const QByteArray &magic, int headerSize);
+    ~SegmentSet();
+
+    const QVector<Segment> &segments() const { return list; }
+    QStringList names() const;
+
+    // 打开并映射段文件，追加到末尾；无法打开或头部不符的文件被跳过
+    void append(const QStringList &names);
+
+    // 需要合并时返回第一个参与合并的段，否则返回 -1
+    int mergeStart() const;
+
+    // 以 name 替换 first 之后的段(name 为空时只移除)，返回被替换的段名，文件由调用方在不再访问后删除
+    QStringList replace(int first, const QString &name);
+
+    // 保存清单后再替换: saveList 以新的段列表保存清单，失败时删除新段并返回 false；
+    // 成功后在 lock 保护下替换内存中的段，再删除旧段文件
+    bool commit(int first, const QString &name, const std::function<bool(const QStringList &)> &saveList,
+                QMutex *lock = nullptr);
+
+    void removeFiles(const QStringList &names) const;
+
+    // 删除目录中与 patterns 匹配但不在 keep 中的文件，即写好新文件后、保存清单前中断留下的文件
+    static void removeUnlisted(const QString &dirPath, const QStringList &patterns, const QStringList &keep);
+
+private:
+    QString dirPath;
+    QByteArray magic;
+    int headerSize;
+    QVector<Segment> list;
+
+    static int level(qint64 size);
+};
+
+#endif // SEGMENTSET_H
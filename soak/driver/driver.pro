@@ -0,0 +1,34 @@
+QT       += core gui concurrent widgets multimedia multimediawidgets
+
+TARGET = soak_driver
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 与桩程序放在同一目录，config.json 中使用相对路径
+DESTDIR = $$OUT_PWD/../bin
+INCLUDEPATH += $$PWD/.. $$PWD/../..
+
+SOURCES += \
+        soakdriver.cpp \
+        ../../mainwindow.cpp \
+        ../../audiofingerprint.cpp \
+        ../../transcriptindex.cpp \
+        ../../segmentset.cpp \
+        ../../subtitlewriter.cpp \
+        ../../whisperoutput.cpp
+
+HEADERS += \
+        ../stubcommon.h \
+        ../../mainwindow.h \
+        ../../subtitlecue.h \
+        ../../audiofingerprint.h \
+        ../../transcriptindex.h \
+        ../../segmentset.h \
+        ../../subtitlewriter.h \
+        ../../whisperoutput.h
+
+FORMS += \
+        ../../mainwindow.ui
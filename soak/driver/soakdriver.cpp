@@ -0,0 +1,678 @@
+// 压力测试驱动
+//
+// 在同一个 MainWindow 上连续运行大量模拟任务，外部程序换成 stub_ffmpeg / stub_wav2srt。
+// 每个任务随机选择音频时长、输出截断方式、崩溃点、启动延迟，部分任务中途点击停止，
+// 部分任务重新处理之前的视频(录音变长)或使用与之前相同的音频，用于测试增量转写和重复片段复用，
+// 部分任务临时移走一个桩程序，测试外部程序无法启动时的处理。
+// 最后统计吞吐量、延迟分位数、UI线程卡顿时间，逐条核对生成的各格式字幕，并检查检索结果。
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QMessageBox>
+#include <QMimeData>
+#include <QPushButton>
+#include <QRegularExpression>
+#include <QTimer>
+#include <QUrl>
+#include <algorithm>
+#include <cstdio>
+#include "mainwindow.h"
+#include "stubcommon.h"
+
+// UI线程两次定时器回调间隔超过该值视为卡顿(毫秒)
+static const qint64 kStallThresholdMs = 50;
+
+// 程序目录中桩程序的完整路径
+static QString stubPath(const QString &name)
+{
+#ifdef Q_OS_WIN
+    return QCoreApplication::applicationDirPath() + "/" + name + ".exe";
+#else
+    return QCoreApplication::applicationDirPath() + "/" + name;
+#endif
+}
+
+// 一个任务的预期与结果
+struct SoakJob {
+    StubParams params;
+    bool stopPlanned;
+    int stopDelayMs;
+    QString videoPath;
+    bool rerun;                             // 重新处理之前的视频
+    bool repeated;                          // 使用与之前某个任务相同的音频
+    QString missingTool;                    // 本任务期间被移走的桩程序，为空表示没有
+    QHash<QString, QByteArray> oldOutputs;  // 开始前已有的字幕文件，失败或停止时不应改变
+    bool timedOut;
+
+    QString outcome;        // success / failed / stopped / other
+    qint64 latencyMs;
+    QStringList errors;
+};
+
+// 解析SRT文件
+static QVector<SubtitleCue> readSrt(const QString &path, bool *ok)
+{
+    QVector<SubtitleCue> cues;
+    QFile file(path);
+    *ok = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (!*ok) {
+        return cues;
+    }
+
+    static const QRegularExpression timeRegex("^(\\d\\d):(\\d\\d):(\\d\\d),(\\d\\d\\d) --> (\\d\\d):(\\d\\d):(\\d\\d),(\\d\\d\\d)$");
+    QStringList blocks = QString::fromUtf8(file.readAll()).split("\n\n", Qt::SkipEmptyParts);
+    for (const QString &block : blocks) {
+        QStringList lines = block.split('\n');
+        QRegularExpressionMatch match = lines.size() >= 2 ? timeRegex.match(lines[1]) : QRegularExpressionMatch();
+        if (!match.hasMatch()) {
+            *ok = false;
+            continue;
+        }
+
+        SubtitleCue cue;
+        cue.startMs = match.captured(1).toInt() * 3600000LL + match.captured(2).toInt() * 60000LL +
+                      match.captured(3).toInt() * 1000LL + match.captured(4).toInt();
+        cue.endMs = match.captured(5).toInt() * 3600000LL + match.captured(6).toInt() * 60000LL +
+                    match.captured(7).toInt() * 1000LL + match.captured(8).toInt();
+        cue.text = lines.mid(2).join('\n');
+        cues.append(cue);
+    }
+    return cues;
+}
+
+static qint64 percentile(QVector<qint64> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qMin(values.size() - 1, static_cast<int>(values.size() * p));
+    return values[index];
+}
+
+// WebVTT 时间 HH:MM:SS.mmm
+static QString vttTime(qint64 ms)
+{
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3600000, 2, 10, QChar('0'))
+        .arg((ms % 3600000) / 60000, 2, 10, QChar('0'))
+        .arg((ms % 60000) / 1000, 2, 10, QChar('0'))
+        .arg(ms % 1000, 3, 10, QChar('0'));
+}
+
+// ASS 时间 H:MM:SS.cc
+static QString assTime(qint64 ms)
+{
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3600000)
+        .arg((ms % 3600000) / 60000, 2, 10, QChar('0'))
+        .arg((ms % 60000) / 1000, 2, 10, QChar('0'))
+        .arg((ms % 1000) / 10, 2, 10, QChar('0'));
+}
+
+// 逐行比较文件内容，prefix 非空时只比较以它开头的行，返回第一处不同，相同时返回空
+static QString compareLines(const QString &path, const QStringList &expected, const QString &prefix = QString())
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return "cannot open " + path;
+    }
+
+    QStringList actual;
+    for (const QString &line : QString::fromUtf8(file.readAll()).split('\n')) {
+        if (prefix.isEmpty() || line.startsWith(prefix)) {
+            actual.append(line);
+        }
+    }
+
+    for (int i = 0; i < qMax(actual.size(), expected.size()); ++i) {
+        QString a = i < actual.size() ? actual[i] : "<end of file>";
+        QString e = i < expected.size() ? expected[i] : "<end of file>";
+        if (a != e) {
+            return QString("%1 line %2: \"%3\", expected \"%4\"").arg(QFileInfo(path).fileName()).arg(i + 1).arg(a, e);
+        }
+    }
+    return QString();
+}
+
+class SoakDriver : public QObject
+{
+public:
+    SoakDriver(const QCommandLineParser &parser, const QString &workDir)
+        : workDir(workDir), random(parser.value("seed").toUInt()), current(-1), window(nullptr)
+    {
+        jobCount = parser.value("jobs").toInt();
+        minDurationMs = parser.value("min-duration").toLongLong() * 1000;
+        maxDurationMs = qMax(minDurationMs, parser.value("max-duration").toLongLong() * 1000);
+        cuesPerSecond = parser.value("cue-rate").toInt();
+        crashRate = parser.value("crash-rate").toDouble();
+        ffmpegFailRate = parser.value("ffmpeg-fail-rate").toDouble();
+        stopRate = parser.value("stop-rate").toDouble();
+        repeatRate = parser.value("repeat-rate").toDouble();
+        rerunRate = parser.value("rerun-rate").toDouble();
+        missingToolRate = parser.value("missing-tool-rate").toDouble();
+        maxLatencyMs = parser.value("max-latency").toInt();
+        timeoutMs = parser.value("timeout").toLongLong() * 1000;
+        formats = parser.value("formats").split(',', Qt::SkipEmptyParts);
+        reuseEnabled = !parser.isSet("no-dedup") || !parser.isSet("no-incremental");
+
+        lastTickMs = 0;
+        maxGapMs = 0;
+        stallMs = 0;
+        stallCount = 0;
+    }
+
+    void run(MainWindow *mainWindow)
+    {
+        window = mainWindow;
+
+        // 用高频定时器测量UI线程的响应，同时负责关闭任务结束时弹出的消息框
+        connect(&ticker, &QTimer::timeout, this, [this]() { tick(); });
+        ticker.setTimerType(Qt::PreciseTimer);
+        ticker.start(5);
+
+        clock.start();
+        QTimer::singleShot(0, this, [this]() { startNextJob(); });
+    }
+
+private:
+    QString workDir;
+    StubRandom random;
+    int jobCount;
+    qint64 minDurationMs;
+    qint64 maxDurationMs;
+    int cuesPerSecond;
+    double crashRate;
+    double ffmpegFailRate;
+    double stopRate;
+    double repeatRate;
+    double rerunRate;
+    double missingToolRate;
+    int maxLatencyMs;
+    qint64 timeoutMs;
+    QStringList formats;
+    bool reuseEnabled;
+
+    QVector<SoakJob> jobs;
+    QHash<QString, StubParams> latestParams;    // 每个视频最近一次的参数
+    int current;
+    MainWindow *window;
+    QTimer ticker;
+    QElapsedTimer clock;
+    QElapsedTimer jobTimer;
+    qint64 lastTickMs;
+    qint64 maxGapMs;
+    qint64 stallMs;
+    int stallCount;
+
+    double chance()
+    {
+        return random.next() / 4294967296.0;
+    }
+
+    void tick()
+    {
+        qint64 now = clock.elapsed();
+        qint64 gap = now - lastTickMs;
+        lastTickMs = now;
+        maxGapMs = qMax(maxGapMs, gap);
+        if (gap > kStallThresholdMs) {
+            stallMs += gap;
+            stallCount++;
+        }
+
+        QMessageBox *box = qobject_cast<QMessageBox *>(QApplication::activeModalWidget());
+        if (box != nullptr && box->isVisible()) {
+            QString title = box->windowTitle();
+            QString text = box->text();
+            box->done(QMessageBox::Ok);
+            jobFinished(title, text);
+            return;
+        }
+        
+        // 任务卡住时点击停止，避免整个测试挂起
+        if (current >= 0 && current < jobs.size() && jobs[current].outcome.isEmpty() &&
+            !jobs[current].timedOut && jobTimer.elapsed() > timeoutMs) {
+            jobs[current].timedOut = true;
+            jobs[current].errors << QString("no result after %1 ms, stopping").arg(jobTimer.elapsed());
+            QTimer::singleShot(0, this, [this]() {
+                window->findChild<QPushButton *>("stopButton")->click();
+            });
+        }
+    }
+
+    void startNextJob()
+    {
+        if (++current >= jobCount) {
+            report();
+            return;
+        }
+
+        SoakJob job;
+        job.rerun = false;
+        job.repeated = false;
+        if (current > 0 && chance() < rerunRate) {
+            // 重新处理之前的视频，录音在原来的基础上变长，用于测试增量转写
+            job.videoPath = jobs[random.bounded(0, current - 1)].videoPath;
+            job.params = latestParams.value(job.videoPath);
+            job.params.durationMs += random.bounded(int(minDurationMs / 10), int(maxDurationMs / 10)) * 10 / 2;
+            job.rerun = true;
+        } else if (current > 0 && chance() < repeatRate) {
+            // 与之前某个任务的音频相同，用于测试重复片段复用
+            job.params = jobs[random.bounded(0, current - 1)].params;
+            job.repeated = true;
+        } else {
+            job.params.seed = random.next();
+            job.params.durationMs = random.bounded(int(minDurationMs / 10), int(maxDurationMs / 10)) * 10;
+        }
+        job.params.cuesPerSecond = cuesPerSecond;
+        job.params.latencyMs = random.bounded(0, maxLatencyMs);
+        job.params.ffmpegFail = chance() < ffmpegFailRate;
+
+        // 截断方式: 逐字节、随机小块、整行
+        int fragmentation = random.bounded(0, 2);
+        job.params.chunkBytes = fragmentation == 0 ? 1 : fragmentation == 1 ? random.bounded(2, 40) : 65536;
+
+        int cueCount = stubCues(job.params).size();
+        job.params.crashAtCue = (cueCount > 0 && chance() < crashRate) ? random.bounded(0, cueCount - 1) : -1;
+
+        job.stopPlanned = chance() < stopRate;
+        job.stopDelayMs = random.bounded(0, int(job.params.durationMs / 50));
+
+        // 移走一个桩程序，模拟配置了错误的路径；只用于全新的音频，保证 wav2srt 一定会被启动
+        if (!job.rerun && !job.repeated && chance() < missingToolRate) {
+            job.missingTool = random.bounded(0, 1) == 0 ? "stub_ffmpeg" : "stub_wav2srt";
+            job.params.ffmpegFail = false;
+            job.params.crashAtCue = -1;
+            job.stopPlanned = false;
+        }
+        if (!job.rerun) {
+            job.videoPath = QString("%1/job_%2.mp4").arg(workDir).arg(current, 4, 10, QChar('0'));
+        }
+        job.latencyMs = 0;
+        job.timedOut = false;
+
+        QString basePath = job.videoPath.left(job.videoPath.size() - 4);
+        for (const QString &format : formats) {
+            QFile output(basePath + "." + format);
+            if (output.open(QIODevice::ReadOnly)) {
+                job.oldOutputs.insert(format, output.readAll());
+            }
+        }
+
+        QFile video(job.videoPath);
+        if (video.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            video.write("stub video\n");
+        }
+        latestParams.insert(job.videoPath, job.params);
+        jobs.append(job);
+
+        // 桩程序从环境变量读取本任务的参数
+        job.params.toEnvironment();
+        if (!job.missingTool.isEmpty()) {
+            QString stub = stubPath(job.missingTool);
+            if (!QFile::rename(stub, stub + ".missing")) {
+                jobs.last().errors << "cannot move " + stub;
+            }
+        }
+
+        // 与用户操作相同: 拖入视频文件，点击开始
+        QMimeData mimeData;
+        mimeData.setUrls(QList<QUrl>() << QUrl::fromLocalFile(job.videoPath));
+        QDropEvent dropEvent(QPointF(10, 10), Qt::CopyAction, &mimeData, Qt::LeftButton, Qt::NoModifier);
+        QApplication::sendEvent(window, &dropEvent);
+
+        jobTimer.start();
+        window->findChild<QPushButton *>("startButton")->click();
+
+        if (job.stopPlanned) {
+            int jobIndex = current;
+            QTimer::singleShot(job.stopDelayMs, this, [this, jobIndex]() {
+                QPushButton *stopButton = window->findChild<QPushButton *>("stopButton");
+                if (current == jobIndex && stopButton->isEnabled()) {
+                    stopButton->click();
+                }
+            });
+        }
+    }
+
+    void jobFinished(const QString &title, const QString &text)
+    {
+        if (current < 0 || current >= jobs.size() || !jobs[current].outcome.isEmpty()) {
+            return;
+        }
+
+        SoakJob &job = jobs[current];
+        job.latencyMs = jobTimer.elapsed();
+        if (!job.missingTool.isEmpty()) {
+            QFile::rename(stubPath(job.missingTool) + ".missing", stubPath(job.missingTool));
+            if (!text.startsWith("无法启动")) {
+                job.errors << QString("%1 was missing, but the message was: %2").arg(job.missingTool, text);
+            }
+        }
+        if (title == "成功") {
+            job.outcome = "success";
+        } else if (title == "错误") {
+            job.outcome = "failed";
+        } else if (text == "处理已停止") {
+            job.outcome = "stopped";
+        } else {
+            job.outcome = "other";
+            job.errors << "unexpected message: " + title + " / " + text;
+        }
+
+        verify(job);
+
+        // 检索索引在后台更新，稍后查询本任务的字幕
+        QVector<SubtitleCue> expected = stubCues(job.params);
+        if (job.outcome == "success" && !expected.isEmpty()) {
+            QTimer::singleShot(0, this, [this]() { verifySearch(0); });
+        } else {
+            QTimer::singleShot(0, this, [this]() { startNextJob(); });
+        }
+    }
+
+    // 用最长的一条字幕查询，最新加入的文件应排在第一位，且能找到这条字幕
+    void verifySearch(int attempt)
+    {
+        SoakJob &job = jobs[current];
+        QVector<SubtitleCue> expected = stubCues(job.params);
+        const SubtitleCue *target = &expected.first();
+        for (const SubtitleCue &cue : expected) {
+            if (cue.text.size() > target->text.size()) {
+                target = &cue;
+            }
+        }
+
+        window->findChild<QLineEdit *>("searchLineEdit")->setText(target->text);
+        window->findChild<QPushButton *>("searchButton")->click();
+
+        QListWidget *results = window->findChild<QListWidget *>("searchResultList");
+        bool newestFirst = results->count() > 0 && results->item(0)->data(Qt::UserRole).toString() == job.videoPath;
+        bool found = false;
+        for (int i = 0; i < results->count(); ++i) {
+            QListWidgetItem *item = results->item(i);
+            if (item->data(Qt::UserRole).toString() == job.videoPath &&
+                item->data(Qt::UserRole + 1).toLongLong() == target->startMs) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!(found && newestFirst) && attempt < 100) {
+            QTimer::singleShot(20, this, [this, attempt]() { verifySearch(attempt + 1); });
+            return;
+        }
+        if (!found) {
+            job.errors << QString("search for \"%1\" did not return the cue at %2 ms").arg(target->text).arg(target->startMs);
+        } else if (!newestFirst) {
+            job.errors << QString("search for \"%1\" did not list the newest file first").arg(target->text);
+        }
+        startNextJob();
+    }
+
+    void verify(SoakJob &job)
+    {
+        QString basePath = job.videoPath.left(job.videoPath.size() - 4);
+        bool expectFailure = job.params.ffmpegFail || job.params.crashAtCue >= 0 || !job.missingTool.isEmpty();
+
+        if (job.outcome == "success") {
+            // 重新处理或重复的音频开启复用时，崩溃点可能落在复用的片段里而不会执行到
+            bool crashSkipped = reuseEnabled && (job.rerun || job.repeated) &&
+                                !job.params.ffmpegFail && job.missingTool.isEmpty();
+            if (expectFailure && !crashSkipped) {
+                job.errors << "succeeded although the stub was set to fail";
+            }
+            verifyOutputs(job, basePath);
+        } else if (job.outcome == "failed" || job.outcome == "stopped") {
+            if (job.outcome == "failed" && !expectFailure) {
+                job.errors << "failed without an injected fault";
+            }
+            if (job.outcome == "stopped" && !job.stopPlanned && !job.timedOut) {
+                job.errors << "stopped without clicking stop";
+            }
+            // 失败或停止时不应留下或改动任何字幕文件
+            for (const QString &format : formats) {
+                QFile output(basePath + "." + format);
+                if (!job.oldOutputs.contains(format)) {
+                    if (output.exists()) {
+                        job.errors << "partial output left behind: " + output.fileName();
+                    }
+                } else if (!output.open(QIODevice::ReadOnly) || output.readAll() != job.oldOutputs.value(format)) {
+                    job.errors << "previous output modified: " + output.fileName();
+                }
+            }
+        }
+    }
+
+    void verifyOutputs(SoakJob &job, const QString &basePath)
+    {
+        QVector<SubtitleCue> expected = stubCues(job.params);
+
+        for (const QString &format : formats) {
+            if (!QFile::exists(basePath + "." + format)) {
+                job.errors << "missing output: " + basePath + "." + format;
+            }
+        }
+
+        if (formats.contains("srt")) {
+            bool ok = false;
+            QVector<SubtitleCue> actual = readSrt(basePath + ".srt", &ok);
+            if (!ok) {
+                job.errors << "malformed srt";
+            }
+            if (actual.size() != expected.size()) {
+                job.errors << QString("srt has %1 cues, expected %2").arg(actual.size()).arg(expected.size());
+            }
+            for (int i = 0; i < qMin(actual.size(), expected.size()); ++i) {
+                if (actual[i].startMs != expected[i].startMs || actual[i].endMs != expected[i].endMs ||
+                    actual[i].text != expected[i].text) {
+                    job.errors << QString("srt cue %1 differs: [%2-%3] %4 / expected [%5-%6] %7")
+                                  .arg(i).arg(actual[i].startMs).arg(actual[i].endMs).arg(actual[i].text)
+                                  .arg(expected[i].startMs).arg(expected[i].endMs).arg(expected[i].text);
+                    break;
+                }
+            }
+        }
+
+        // 其余文本格式逐行比较
+        if (formats.contains("txt")) {
+            QStringList lines;
+            for (const SubtitleCue &cue : expected) {
+                if (!lines.isEmpty()) {
+                    lines << "";
+                }
+                lines << cue.text;
+            }
+            lines << "";
+            QString difference = compareLines(basePath + ".txt", lines);
+            if (!difference.isEmpty()) {
+                job.errors << difference;
+            }
+        }
+
+        if (formats.contains("vtt")) {
+            QStringList lines;
+            lines << "WEBVTT" << "";
+            for (const SubtitleCue &cue : expected) {
+                QString text = cue.text;
+                text.replace('&', "&amp;").replace('<', "&lt;").replace('>', "&gt;");
+                lines << vttTime(cue.startMs) + " --> " + vttTime(cue.endMs) << text << "";
+            }
+            lines << "";
+            QString difference = compareLines(basePath + ".vtt", lines);
+            if (!difference.isEmpty()) {
+                job.errors << difference;
+            }
+        }
+
+        if (formats.contains("ass")) {
+            QStringList lines;
+            for (const SubtitleCue &cue : expected) {
+                lines << QString("Dialogue: 0,%1,%2,Default,,0,0,0,,%3").arg(assTime(cue.startMs), assTime(cue.endMs), cue.text);
+            }
+            QString difference = compareLines(basePath + ".ass", lines, "Dialogue:");
+            if (!difference.isEmpty()) {
+                job.errors << difference;
+            }
+        }
+
+        if (formats.contains("json")) {
+            QFile file(basePath + ".json");
+            file.open(QIODevice::ReadOnly);
+            QJsonParseError error;
+            QJsonArray cues = QJsonDocument::fromJson(file.readAll(), &error).object().value("cues").toArray();
+            if (error.error != QJsonParseError::NoError) {
+                job.errors << "malformed json: " + error.errorString();
+            } else if (cues.size() != expected.size()) {
+                job.errors << QString("json has %1 cues, expected %2").arg(cues.size()).arg(expected.size());
+            } else {
+                // token 合并后的词，复用的字幕也应带有逐词时间
+                for (int i = 0; i < cues.size(); ++i) {
+                    QStringList words;
+                    for (const QJsonValue &word : cues[i].toObject().value("words").toArray()) {
+                        words.append(word.toObject().value("text").toString());
+                    }
+                    if (words != stubWords(expected[i].text)) {
+                        job.errors << QString("json cue %1 has words [%2], expected [%3]")
+                                      .arg(i).arg(words.join('|'), stubWords(expected[i].text).join('|'));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void report()
+    {
+        ticker.stop();
+        qint64 totalMs = clock.elapsed();
+
+        int success = 0;
+        int failed = 0;
+        int stopped = 0;
+        int other = 0;
+        int badJobs = 0;
+        qint64 audioMs = 0;
+        QVector<qint64> latencies;
+        for (const SoakJob &job : jobs) {
+            if (job.outcome == "success") {
+                success++;
+                audioMs += job.params.durationMs;
+                latencies.append(job.latencyMs);
+            } else if (job.outcome == "failed") {
+                failed++;
+            } else if (job.outcome == "stopped") {
+                stopped++;
+            } else {
+                other++;
+            }
+            if (!job.errors.isEmpty()) {
+                badJobs++;
+            }
+        }
+
+        printf("jobs:        %d (success %d, failed %d, stopped %d, other %d)\n",
+               jobs.size(), success, failed, stopped, other);
+        printf("wall time:   %.1f s\n", totalMs / 1000.0);
+        printf("throughput:  %.2f jobs/s, %.1f s of audio/s\n",
+               jobs.size() * 1000.0 / qMax<qint64>(1, totalMs), audioMs / double(qMax<qint64>(1, totalMs)));
+        printf("latency:     p50 %lld ms, p95 %lld ms, p99 %lld ms, max %lld ms (successful jobs)\n",
+               percentile(latencies, 0.50), percentile(latencies, 0.95),
+               percentile(latencies, 0.99), percentile(latencies, 1.0));
+        printf("ui stall:    max gap %lld ms, %d gaps over %lld ms totalling %lld ms (%.2f%% of run)\n",
+               maxGapMs, stallCount, kStallThresholdMs, stallMs, stallMs * 100.0 / qMax<qint64>(1, totalMs));
+        printf("correctness: %d of %d jobs with errors\n", badJobs, jobs.size());
+
+        int printed = 0;
+        for (int i = 0; i < jobs.size() && printed < 20; ++i) {
+            for (const QString &error : jobs[i].errors) {
+                printf("  job %d (seed %u, %s): %s\n", i, jobs[i].params.seed,
+                       qPrintable(jobs[i].outcome), qPrintable(error));
+                printed++;
+            }
+        }
+        fflush(stdout);
+
+        QApplication::exit(badJobs == 0 ? 0 : 1);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // 默认不需要显示器
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("voice2srt soak test driver");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "jobs", "Number of simulated jobs.", "n", "200" },
+        { "seed", "Random seed for job parameters.", "n", "1" },
+        { "min-duration", "Shortest simulated audio, seconds.", "s", "10" },
+        { "max-duration", "Longest simulated audio, seconds.", "s", "90" },
+        { "cue-rate", "Cues per second written by the recognizer stub, 0 = unthrottled.", "n", "100" },
+        { "crash-rate", "Fraction of jobs whose recognizer crashes mid-output.", "f", "0.05" },
+        { "ffmpeg-fail-rate", "Fraction of jobs whose audio extraction fails.", "f", "0.02" },
+        { "stop-rate", "Fraction of jobs stopped by the user.", "f", "0.05" },
+        { "repeat-rate", "Fraction of jobs reusing audio of an earlier job under a new file name.", "f", "0.1" },
+        { "rerun-rate", "Fraction of jobs re-processing an earlier video whose recording has grown.", "f", "0.2" },
+        { "missing-tool-rate", "Fraction of jobs run with one stub moved away, as with a wrong tool path.", "f", "0.02" },
+        { "max-latency", "Upper bound of the stubs' startup latency, ms.", "ms", "100" },
+        { "timeout", "Seconds before a job that produced no result is stopped and counted as an error.", "s", "120" },
+        { "formats", "Output formats to enable.", "list", "srt,txt,vtt,ass,json" },
+        { "no-dedup", "Disable reuse of repeated segments (enabled by default, as in the application)." },
+        { "no-incremental", "Disable incremental re-transcription (enabled by default, as in the application)." },
+        { "work-dir", "Directory for simulated videos and outputs.", "dir", QDir::tempPath() + "/voice2srt-soak" },
+    });
+    parser.process(app);
+
+    // 每次从干净的状态开始
+    QString appDir = QCoreApplication::applicationDirPath();
+    QString workDir = parser.value("work-dir");
+    QDir(workDir).removeRecursively();
+    QDir().mkpath(workDir);
+    QDir(appDir + "/fingerprint").removeRecursively();
+    QDir(appDir + "/transcripts").removeRecursively();
+
+    // MainWindow 从程序目录的 config.json 读取外部程序路径
+    QStringList formats = parser.value("formats").split(',', Qt::SkipEmptyParts);
+    QJsonObject config;
+    config["srtEnabled"] = formats.contains("srt");
+    config["txtEnabled"] = formats.contains("txt");
+    config["vttEnabled"] = formats.contains("vtt");
+    config["assEnabled"] = formats.contains("ass");
+    config["jsonEnabled"] = formats.contains("json");
+    config["dedupEnabled"] = !parser.isSet("no-dedup");
+    config["incrementalEnabled"] = !parser.isSet("no-incremental");
+    config["ffmpegPath"] = QFileInfo(stubPath("stub_ffmpeg")).fileName();
+    config["wav2srtPath"] = QFileInfo(stubPath("stub_wav2srt")).fileName();
+    config["modelPath"] = "stub.bin";
+
+    QFile configFile(appDir + "/config.json");
+    if (!configFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "cannot write %s\n", qPrintable(configFile.fileName()));
+        return 2;
+    }
+    configFile.write(QJsonDocument(config).toJson());
+    configFile.close();
+
+    MainWindow window;
+    window.show();
+
+    SoakDriver driver(parser, workDir);
+    driver.run(&window);
+    return app.exec();
+}
@@ -0,0 +1,14 @@
+# 压力测试: 模拟 ffmpeg / wav2srt 的桩程序及驱动
+#
+#   mkdir build && cd build
+#   qmake ../soak/soak.pro && make
+#   ./bin/soak_driver --jobs 300
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+        stub_ffmpeg \
+        stub_wav2srt \
+        driver
+
+driver.depends = stub_ffmpeg stub_wav2srt
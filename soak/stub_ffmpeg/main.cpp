@@ -0,0 +1,125 @@
+// 模拟 ffmpeg 的桩程序，供压力测试使用
+//
+// ffmpeg -i <视频>                       输出视频信息(含 Duration)后以 1 退出
+// ffmpeg -i <视频> ... <输出.wav>         按 VOICE2SRT_STUB_FFMPEG_SPEED 的速度输出进度，
+//                                        生成16kHz单声道16位的WAV
+#include <QCoreApplication>
+#include <QFile>
+#include <QThread>
+#include <QtEndian>
+#include <cstdio>
+#include <cstring>
+#include "stubcommon.h"
+
+static void writeStderr(const QString &text)
+{
+    QByteArray data = text.toUtf8();
+    fwrite(data.constData(), 1, data.size(), stderr);
+    fflush(stderr);
+}
+
+// ffmpeg风格的时间 HH:MM:SS.cc
+static QString ffmpegTime(qint64 ms)
+{
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3600000, 2, 10, QChar('0'))
+        .arg((ms % 3600000) / 60000, 2, 10, QChar('0'))
+        .arg((ms % 60000) / 1000, 2, 10, QChar('0'))
+        .arg((ms % 1000) / 10, 2, 10, QChar('0'));
+}
+
+static void writeBanner(const QString &input, qint64 durationMs)
+{
+    writeStderr("ffmpeg version stub Copyright (c) 2000-2024 the FFmpeg developers\n"
+                "  built with stub\n");
+    writeStderr(QString("Input #0, mov,mp4,m4a,3gp,3g2,mj2, from '%1':\n").arg(input));
+    writeStderr(QString("  Duration: %1, start: 0.000000, bitrate: 1024 kb/s\n").arg(ffmpegTime(durationMs)));
+    writeStderr("  Stream #0:0(und): Audio: aac (LC) (mp4a / 0x6134706D), 44100 Hz, stereo, fltp, 128 kb/s (default)\n");
+}
+
+static QByteArray wavHeader(quint32 dataBytes)
+{
+    QByteArray header(44, '\0');
+    char *p = header.data();
+    memcpy(p, "RIFF", 4);
+    qToLittleEndian<quint32>(36 + dataBytes, p + 4);
+    memcpy(p + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, p + 16);
+    qToLittleEndian<quint16>(1, p + 20);        // PCM
+    qToLittleEndian<quint16>(1, p + 22);        // 单声道
+    qToLittleEndian<quint32>(16000, p + 24);
+    qToLittleEndian<quint32>(32000, p + 28);
+    qToLittleEndian<quint16>(2, p + 32);
+    qToLittleEndian<quint16>(16, p + 34);
+    memcpy(p + 36, "data", 4);
+    qToLittleEndian<quint32>(dataBytes, p + 40);
+    return header;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    StubParams params = StubParams::fromEnvironment();
+    QStringList args = app.arguments().mid(1);
+
+    int inputIndex = args.indexOf("-i");
+    if (inputIndex < 0 || inputIndex + 1 >= args.size()) {
+        writeStderr("stub ffmpeg: missing -i\n");
+        return 1;
+    }
+    QString input = args[inputIndex + 1];
+
+    QThread::msleep(params.latencyMs);
+    writeBanner(input, params.durationMs);
+
+    // 只有 -i 时与 ffmpeg 一样报错退出
+    if (args.size() == inputIndex + 2) {
+        writeStderr("At least one output file must be specified\n");
+        return 1;
+    }
+
+    QFile output(args.last());
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        writeStderr(QString("%1: Permission denied\n").arg(args.last()));
+        return 1;
+    }
+
+    writeStderr(QString("Output #0, wav, to '%1':\n").arg(args.last()));
+    writeStderr("  Stream #0:0(und): Audio: pcm_s16le ([1][0][0][0] / 0x0001), 16000 Hz, mono, s16, 256 kb/s (default)\n");
+
+    quint32 sampleCount = quint32(params.durationMs * 16);
+    output.write(wavHeader(sampleCount * 2));
+
+    // 每500毫秒音频输出一次进度，用带种子的噪声作为音频内容，使不同任务的指纹不同
+    StubRandom random(params.seed ^ 0x5bd1e995u);
+    const qint64 stepMs = 500;
+    QByteArray pcm;
+    for (qint64 doneMs = 0; doneMs < params.durationMs; doneMs += stepMs) {
+        qint64 stepSamples = qMin<qint64>(stepMs, params.durationMs - doneMs) * 16;
+        pcm.resize(int(stepSamples * 2));
+        for (qint64 i = 0; i < stepSamples; ++i) {
+            qToLittleEndian<qint16>(qint16(random.next() >> 20) - 2048, pcm.data() + i * 2);
+        }
+        output.write(pcm);
+
+        if (params.ffmpegFail && doneMs >= params.durationMs / 2) {
+            writeStderr("\nError while decoding stream #0:0: Invalid data found when processing input\n");
+            return 1;
+        }
+
+        qint64 timeMs = doneMs + stepSamples / 16;
+        writeStderr(QString("size=%1kB time=%2 bitrate= 256.0kbits/s speed=%3x    \r")
+                    .arg((44 + timeMs * 32) / 1024, 8)
+                    .arg(ffmpegTime(timeMs))
+                    .arg(params.ffmpegSpeed));
+        QThread::msleep(stepMs / params.ffmpegSpeed);
+    }
+
+    output.close();
+    writeStderr(QString("\nsize=%1kB time=%2 bitrate= 256.0kbits/s speed=%3x\n"
+                        "video:0kB audio:%1kB subtitle:0kB other streams:0kB global headers:0kB muxing overhead: 0.004%\n")
+                .arg((44 + params.durationMs * 32) / 1024, 8)
+                .arg(ffmpegTime(params.durationMs))
+                .arg(params.ffmpegSpeed));
+    return 0;
+}
@@ -0,0 +1,16 @@
+QT       += core
+QT       -= gui
+
+TARGET = stub_ffmpeg
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DESTDIR = $$OUT_PWD/../bin
+INCLUDEPATH += $$PWD/.. $$PWD/../..
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+        ../stubcommon.h
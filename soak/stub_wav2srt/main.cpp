@@ -0,0 +1,158 @@
+// 模拟 wav2srt(whisper.cpp)的桩程序，供压力测试使用
+//
+// 支持 -f <wav> -ot <起点毫秒> -d <时长毫秒> -ojf -of <输出路径>，其余参数忽略。
+// -ojf 输出的 token 与 whisper 一样是字节级片段，汉字常被拆成不完整的UTF-8。
+// 字幕按 VOICE2SRT_STUB_CUES_PER_SECOND 的速度输出到标准输出，每次最多写
+// VOICE2SRT_STUB_CHUNK_BYTES 字节；VOICE2SRT_STUB_CRASH_AT_CUE 指定在哪条字幕处崩溃。
+#include <QCoreApplication>
+#include <QByteArrayList>
+#include <QFile>
+#include <QThread>
+#include <cstdio>
+#include <cstdlib>
+#include "stubcommon.h"
+
+static void writeStderr(const QString &text)
+{
+    QByteArray data = text.toUtf8();
+    fwrite(data.constData(), 1, data.size(), stderr);
+    fflush(stderr);
+}
+
+// 按 chunkBytes 切成多次写入，让读取端看到被截断的行
+static void writeStdout(const QByteArray &data, int chunkBytes)
+{
+    for (int offset = 0; offset < data.size(); offset += chunkBytes) {
+        fwrite(data.constData() + offset, 1, qMin(chunkBytes, data.size() - offset), stdout);
+        fflush(stdout);
+        if (offset + chunkBytes < data.size()) {
+            QThread::usleep(200);
+        }
+    }
+}
+
+// JSON字符串，与whisper一样按原始字节输出，不完整的UTF-8片段原样写入
+static QByteArray jsonString(const QByteArray &bytes)
+{
+    QByteArray out = "\"";
+    for (char c : bytes) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<uchar>(c) < 0x20) {
+            out += "\\u00" + QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0');
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+static QByteArray jsonToken(const QByteArray &text, qint64 from, qint64 to, double p)
+{
+    return "{\"text\": " + jsonString(text) + ", \"offsets\": {\"from\": " + QByteArray::number(from) +
+           ", \"to\": " + QByteArray::number(to) + "}, \"p\": " + QByteArray::number(p, 'f', 6) + "}";
+}
+
+// whisper -ojf 格式的一段，token 为字节级片段
+static QByteArray jsonSegment(const SubtitleCue &cue, StubRandom &random)
+{
+    QVector<QByteArray> tokens = stubTokens(cue.text, random);
+
+    QByteArray out = "{\"offsets\": {\"from\": " + QByteArray::number(cue.startMs) +
+                     ", \"to\": " + QByteArray::number(cue.endMs) + "}, \"text\": " +
+                     jsonString(cue.text.toUtf8()) + ", \"tokens\": [";
+    out += jsonToken("[_BEG_]", cue.startMs, cue.startMs, 1.0);
+    for (int i = 0; i < tokens.size(); ++i) {
+        qint64 from = cue.startMs + (cue.endMs - cue.startMs) * i / tokens.size();
+        qint64 to = cue.startMs + (cue.endMs - cue.startMs) * (i + 1) / tokens.size();
+        out += ", " + jsonToken(tokens[i], from, to, 0.5 + random.bounded(0, 500) / 1000.0);
+    }
+    out += "]}";
+    return out;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    StubParams params = StubParams::fromEnvironment();
+    QStringList args = app.arguments().mid(1);
+
+    qint64 offsetMs = 0;
+    qint64 durationMs = -1;
+    bool outputJson = false;
+    QString outputBase;
+    for (int i = 0; i < args.size(); ++i) {
+        bool hasValue = i + 1 < args.size();
+        if (args[i] == "-ot" && hasValue) {
+            offsetMs = args[++i].toLongLong();
+        } else if (args[i] == "-d" && hasValue) {
+            durationMs = args[++i].toLongLong();
+        } else if (args[i] == "-of" && hasValue) {
+            outputBase = args[++i];
+        } else if (args[i] == "-ojf") {
+            outputJson = true;
+        }
+    }
+    qint64 endMs = durationMs >= 0 ? offsetMs + durationMs : params.durationMs;
+
+    QThread::msleep(params.latencyMs);
+    writeStderr("whisper_init_from_file_with_params_no_state: loading model from 'stub'\n"
+                "whisper_model_load: type          = 2 (base)\n"
+                "whisper_model_load: model size    =  141.11 MB\n"
+                "\n"
+                "system_info: n_threads = 4 / 8 | AVX = 1 | AVX2 = 1 |\n"
+                "\n");
+    writeStderr(QString("main: processing 'stub' (%1 samples, %2 sec), 4 threads, 1 processors, lang = zh, task = transcribe, timestamps = 1 ...\n\n")
+                .arg(params.durationMs * 16)
+                .arg(params.durationMs / 1000.0, 0, 'f', 1));
+
+    // 只输出起点落在本次区间内的字幕
+    QVector<SubtitleCue> allCues = stubCues(params);
+    QVector<int> selected;
+    for (int i = 0; i < allCues.size(); ++i) {
+        if (allCues[i].startMs >= offsetMs && allCues[i].startMs < endMs) {
+            selected.append(i);
+        }
+    }
+
+    StubRandom random(params.seed ^ 0x9e3779b9u);
+    QByteArrayList transcription;
+    int lastProgress = 0;
+    for (int n = 0; n < selected.size(); ++n) {
+        const SubtitleCue &cue = allCues[selected[n]];
+        QByteArray line = QString("[%1 --> %2]  %3\n").arg(stubTimestamp(cue.startMs), stubTimestamp(cue.endMs), cue.text).toUtf8();
+
+        if (selected[n] == params.crashAtCue) {
+            // 写出半行后崩溃
+            writeStdout(line.left(line.size() / 2), params.chunkBytes);
+            abort();
+        }
+
+        writeStdout(line, params.chunkBytes);
+        transcription.append(jsonSegment(cue, random));
+
+        int progress = (n + 1) * 100 / selected.size();
+        if (progress / 10 > lastProgress / 10) {
+            writeStderr(QString("whisper_print_progress_callback: progress = %1%\n").arg(progress, 3));
+            lastProgress = progress;
+        }
+
+        if (params.cuesPerSecond > 0) {
+            QThread::msleep(1000 / params.cuesPerSecond);
+        }
+    }
+
+    if (outputJson && !outputBase.isEmpty()) {
+        QFile file(outputBase + ".json");
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write("{\"systeminfo\": \"stub\", \"transcription\": [\n" + transcription.join(",\n") + "\n]}\n");
+        }
+        writeStderr(QString("output_json: saving output to '%1.json'\n").arg(outputBase));
+    }
+
+    writeStderr("\nwhisper_print_timings:     load time =    50.00 ms\n"
+                "whisper_print_timings:    total time =   100.00 ms\n");
+    return 0;
+}
@@ -0,0 +1,176 @@
+#ifndef STUBCOMMON_H
+#define STUBCOMMON_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include "subtitlecue.h"
+
+// 桩程序和压力测试驱动共用的任务参数及字幕生成规则
+//
+// 驱动在启动每个任务前通过环境变量设置参数，主程序启动的桩程序继承这些环境变量，
+// 驱动再用同样的规则生成期望的字幕，与主程序的输出比对。
+struct StubParams {
+    quint32 seed;           // 决定音频内容和字幕内容
+    qint64 durationMs;      // 音频时长
+    int cueMs;              // 平均每条字幕的时长
+    int cuesPerSecond;      // wav2srt每秒输出的字幕条数，0 表示不限速
+    int chunkBytes;         // 标准输出每次最多写入的字节数，用于制造截断
+    int latencyMs;          // 桩程序启动延迟
+    int crashAtCue;         // wav2srt输出到第几条字幕时崩溃，-1 表示不崩溃
+    bool ffmpegFail;        // ffmpeg提取音频中途失败
+    int ffmpegSpeed;        // ffmpeg处理速度(实时的倍数)
+
+    StubParams()
+        : seed(1), durationMs(30000), cueMs(2500), cuesPerSecond(50), chunkBytes(4096),
+          latencyMs(50), crashAtCue(-1), ffmpegFail(false), ffmpegSpeed(100)
+    {
+    }
+
+    static StubParams fromEnvironment()
+    {
+        StubParams params;
+        params.seed = qEnvironmentVariable("VOICE2SRT_STUB_SEED", "1").toUInt();
+        params.durationMs = qEnvironmentVariable("VOICE2SRT_STUB_DURATION_MS", "30000").toLongLong();
+        params.cueMs = qEnvironmentVariable("VOICE2SRT_STUB_CUE_MS", "2500").toInt();
+        params.cuesPerSecond = qEnvironmentVariable("VOICE2SRT_STUB_CUES_PER_SECOND", "50").toInt();
+        params.chunkBytes = qMax(1, qEnvironmentVariable("VOICE2SRT_STUB_CHUNK_BYTES", "4096").toInt());
+        params.latencyMs = qEnvironmentVariable("VOICE2SRT_STUB_LATENCY_MS", "50").toInt();
+        params.crashAtCue = qEnvironmentVariable("VOICE2SRT_STUB_CRASH_AT_CUE", "-1").toInt();
+        params.ffmpegFail = qEnvironmentVariableIntValue("VOICE2SRT_STUB_FFMPEG_FAIL") != 0;
+        params.ffmpegSpeed = qMax(1, qEnvironmentVariable("VOICE2SRT_STUB_FFMPEG_SPEED", "100").toInt());
+        return params;
+    }
+
+    void toEnvironment() const
+    {
+        qputenv("VOICE2SRT_STUB_SEED", QByteArray::number(seed));
+        qputenv("VOICE2SRT_STUB_DURATION_MS", QByteArray::number(durationMs));
+        qputenv("VOICE2SRT_STUB_CUE_MS", QByteArray::number(cueMs));
+        qputenv("VOICE2SRT_STUB_CUES_PER_SECOND", QByteArray::number(cuesPerSecond));
+        qputenv("VOICE2SRT_STUB_CHUNK_BYTES", QByteArray::number(chunkBytes));
+        qputenv("VOICE2SRT_STUB_LATENCY_MS", QByteArray::number(latencyMs));
+        qputenv("VOICE2SRT_STUB_CRASH_AT_CUE", QByteArray::number(crashAtCue));
+        qputenv("VOICE2SRT_STUB_FFMPEG_FAIL", ffmpegFail ? "1" : "0");
+        qputenv("VOICE2SRT_STUB_FFMPEG_SPEED", QByteArray::number(ffmpegSpeed));
+    }
+};
+
+// 可复现的伪随机数(xorshift32)
+class StubRandom
+{
+public:
+    explicit StubRandom(quint32 seed) : state(seed * 2654435761u + 1) {}
+
+    quint32 next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // [low, high]
+    int bounded(int low, int high)
+    {
+        return low + static_cast<int>(next() % quint32(high - low + 1));
+    }
+
+private:
+    quint32 state;
+};
+
+// 按参数生成整段音频的字幕，时间精确到10毫秒(与whisper输出一致)
+inline QVector<SubtitleCue> stubCues(const StubParams &params)
+{
+    static const char *const phrases[] = {
+        "我们", "今天", "讨论", "项目", "进度", "预算", "下一步", "需要", "确认", "数据",
+        "会议", "记录", "客户", "反馈", "方案", "测试", "上线", "时间", "问题", "负责"
+    };
+    const int phraseCount = sizeof(phrases) / sizeof(phrases[0]);
+
+    QVector<SubtitleCue> cues;
+    StubRandom random(params.seed);
+    qint64 cursor = random.bounded(0, 50) * 10;
+
+    while (cursor + 500 <= params.durationMs) {
+        SubtitleCue cue;
+        cue.startMs = cursor;
+        cue.endMs = qMin(params.durationMs, cursor + random.bounded(params.cueMs / 20, params.cueMs * 3 / 20) * 10);
+
+        int words = random.bounded(2, 8);
+        for (int i = 0; i < words; ++i) {
+            cue.text += QString::fromUtf8(phrases[random.bounded(0, phraseCount - 1)]);
+        }
+        // 偶尔带上需要转义的字符和英文
+        if (random.bounded(0, 9) == 0) {
+            cue.text += QString(" R&D <v%1>").arg(random.bounded(1, 9));
+        }
+
+        cues.append(cue);
+        cursor = cue.endMs + random.bounded(0, 20) * 10;
+    }
+
+    return cues;
+}
+
+// whisper风格的 token: 字节级BPE片段，汉字有时被拆成两个不完整的UTF-8片段，空格归入后一个 token
+inline QVector<QByteArray> stubTokens(const QString &text, StubRandom &random)
+{
+    QVector<QByteArray> tokens;
+    QByteArray space;
+    for (QChar ch : text) {
+        if (ch == ' ') {
+            space = " ";
+            continue;
+        }
+
+        QByteArray bytes = QString(ch).toUtf8();
+        if (bytes.size() > 1 && space.isEmpty() && random.bounded(0, 2) > 0) {
+            int split = random.bounded(1, bytes.size() - 1);
+            tokens.append(bytes.left(split));
+            tokens.append(bytes.mid(split));
+        } else {
+            tokens.append(space + bytes);
+        }
+        space.clear();
+    }
+    return tokens;
+}
+
+// 主程序合并 token 后应得到的词: 每个汉字一个词，其余按空格分开
+inline QStringList stubWords(const QString &text)
+{
+    QStringList words;
+    QString current;
+    for (QChar ch : text) {
+        if (ch == ' ' || ch.unicode() >= 0x800) {
+            if (!current.isEmpty()) {
+                words.append(current);
+                current.clear();
+            }
+            if (ch != ' ') {
+                words.append(QString(ch));
+            }
+        } else {
+            current += ch;
+        }
+    }
+    if (!current.isEmpty()) {
+        words.append(current);
+    }
+    return words;
+}
+
+// whisper风格的时间戳 HH:MM:SS.mmm
+inline QString stubTimestamp(qint64 ms)
+{
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3600000, 2, 10, QChar('0'))
+        .arg((ms % 3600000) / 60000, 2, 10, QChar('0'))
+        .arg((ms % 60000) / 1000, 2, 10, QChar('0'))
+        .arg(ms % 1000, 3, 10, QChar('0'));
+}
+
+#endif // STUBCOMMON_H
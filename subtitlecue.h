@@ -0,0 +1,23 @@
+#ifndef SUBTITLECUE_H
+#define SUBTITLECUE_H
+
+#include <QString>
+#include <QVector>
+
+// 字幕中的一个词(时间单位: 毫秒)
+struct SubtitleWord {
+    qint64 startMs;
+    qint64 endMs;
+    QString text;
+    double confidence;  // 0~1
+};
+
+// 一条字幕(时间单位: 毫秒)
+struct SubtitleCue {
+    qint64 startMs;
+    qint64 endMs;
+    QString text;
+    QVector<SubtitleWord> words;  // 逐词时间，可能为空
+};
+
+#endif // SUBTITLECUE_H
@@ -0,0 +1,296 @@
+#include "subtitlewriter.h"
+#include <QSaveFile>
+
+// 每条字幕预估的输出字节数，用于预先分配缓冲区
+static const int kBytesPerCue = 96;
+
+// 追加固定宽度的十进制数
+static void appendNumber(QByteArray &out, qint64 value, int width)
+{
+    char digits[24];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0 && length < static_cast<int>(sizeof(digits)));
+
+    for (int i = length; i < width; ++i) {
+        out.append('0');
+    }
+    while (length > 0) {
+        out.append(digits[--length]);
+    }
+}
+
+// 追加时间戳 H:MM:SS 加毫秒(或厘秒)部分
+static void appendTime(QByteArray &out, qint64 ms, int hourWidth, char fractionSeparator, bool centiseconds)
+{
+    if (ms < 0) {
+        ms = 0;
+    }
+    appendNumber(out, ms / 3600000, hourWidth);
+    out.append(':');
+    appendNumber(out, (ms % 3600000) / 60000, 2);
+    out.append(':');
+    appendNumber(out, (ms % 60000) / 1000, 2);
+    out.append(fractionSeparator);
+    if (centiseconds) {
+        appendNumber(out, (ms % 1000) / 10, 2);
+    } else {
+        appendNumber(out, ms % 1000, 3);
+    }
+}
+
+// 追加JSON字符串(含引号)
+static void appendJsonString(QByteArray &out, const QString &text)
+{
+    out.append('"');
+    for (char c : text.toUtf8()) {
+        switch (c) {
+        case '"':  out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out.append("\\u00");
+                out.append("0123456789abcdef"[(c >> 4) & 0xf]);
+                out.append("0123456789abcdef"[c & 0xf]);
+            } else {
+                out.append(c);
+            }
+        }
+    }
+    out.append('"');
+}
+
+// SRT: 序号、时间行、文本、空行
+class SrtWriter : public SubtitleWriter
+{
+public:
+    QString suffix() const override { return ".srt"; }
+
+    void writeCue(QByteArray &out, int index, const SubtitleCue &cue) override
+    {
+        appendNumber(out, index + 1, 1);
+        out.append('\n');
+        appendTime(out, cue.startMs, 2, ',', false);
+        out.append(" --> ");
+        appendTime(out, cue.endMs, 2, ',', false);
+        out.append('\n');
+        if (!cue.text.isEmpty()) {
+            out.append(cue.text.toUtf8());
+            out.append('\n');
+        }
+        out.append('\n');
+    }
+};
+
+// 纯文本: 每条字幕一段，段之间空一行
+class TxtWriter : public SubtitleWriter
+{
+public:
+    QString suffix() const override { return ".txt"; }
+
+    void writeCue(QByteArray &out, int index, const SubtitleCue &cue) override
+    {
+        Q_UNUSED(index);
+        if (cue.text.isEmpty()) {
+            return;
+        }
+        if (!out.isEmpty()) {
+            out.append('\n');
+        }
+        out.append(cue.text.toUtf8());
+        out.append('\n');
+    }
+};
+
+// WebVTT
+class VttWriter : public SubtitleWriter
+{
+public:
+    QString suffix() const override { return ".vtt"; }
+
+    void writeHeader(QByteArray &out) override
+    {
+        out.append("WEBVTT\n\n");
+    }
+
+    void writeCue(QByteArray &out, int index, const SubtitleCue &cue) override
+    {
+        Q_UNUSED(index);
+        appendTime(out, cue.startMs, 2, '.', false);
+        out.append(" --> ");
+        appendTime(out, cue.endMs, 2, '.', false);
+        out.append('\n');
+        if (!cue.text.isEmpty()) {
+            // 文本中的 & < > 需要转义
+            QByteArray text = cue.text.toUtf8();
+            text.replace('&', "&amp;").replace('<', "&lt;").replace('>', "&gt;");
+            out.append(text);
+            out.append('\n');
+        }
+        out.append('\n');
+    }
+};
+
+// ASS (Advanced SubStation Alpha)
+class AssWriter : public SubtitleWriter
+{
+public:
+    QString suffix() const override { return ".ass"; }
+
+    void writeHeader(QByteArray &out) override
+    {
+        out.append("[Script Info]\n"
+                   "ScriptType: v4.00+\n"
+                   "PlayResX: 1920\n"
+                   "PlayResY: 1080\n"
+                   "\n"
+                   "[V4+ Styles]\n"
+                   "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, "
+                   "Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, "
+                   "Alignment, MarginL, MarginR, MarginV, Encoding\n"
+                   "Style: Default,Microsoft YaHei,60,&H00FFFFFF,&H000000FF,&H00000000,&H80000000,"
+                   "0,0,0,0,100,100,0,0,1,2,1,2,20,20,40,1\n"
+                   "\n"
+                   "[Events]\n"
+                   "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n");
+    }
+
+    void writeCue(QByteArray &out, int index, const SubtitleCue &cue) override
+    {
+        Q_UNUSED(index);
+        out.append("Dialogue: 0,");
+        appendTime(out, cue.startMs, 1, '.', true);
+        out.append(',');
+        appendTime(out, cue.endMs, 1, '.', true);
+        out.append(",Default,,0,0,0,,");
+        // 换行写作 \N
+        out.append(cue.text.toUtf8().replace('\n', "\\N"));
+        out.append('\n');
+    }
+};
+
+// JSON: 字幕及逐词时间、置信度
+class JsonWriter : public SubtitleWriter
+{
+public:
+    QString suffix() const override { return ".json"; }
+
+    void writeHeader(QByteArray &out) override
+    {
+        out.append("{\"cues\":[");
+    }
+
+    void writeCue(QByteArray &out, int index, const SubtitleCue &cue) override
+    {
+        if (index > 0) {
+            out.append(',');
+        }
+        out.append("\n{\"start\":");
+        out.append(QByteArray::number(cue.startMs));
+        out.append(",\"end\":");
+        out.append(QByteArray::number(cue.endMs));
+        out.append(",\"text\":");
+        appendJsonString(out, cue.text);
+        out.append(",\"words\":[");
+        for (int i = 0; i < cue.words.size(); ++i) {
+            const SubtitleWord &word = cue.words[i];
+            if (i > 0) {
+                out.append(',');
+            }
+            out.append("{\"start\":");
+            out.append(QByteArray::number(word.startMs));
+            out.append(",\"end\":");
+            out.append(QByteArray::number(word.endMs));
+            out.append(",\"text\":");
+            appendJsonString(out, word.text);
+            out.append(",\"confidence\":");
+            out.append(QByteArray::number(word.confidence, 'f', 3));
+            out.append('}');
+        }
+        out.append("]}");
+    }
+
+    void writeFooter(QByteArray &out) override
+    {
+        out.append("\n]}\n");
+    }
+};
+
+SubtitleWriter *SubtitleWriter::create(const QString &format)
+{
+    if (format == "srt") return new SrtWriter;
+    if (format == "txt") return new TxtWriter;
+    if (format == "vtt") return new VttWriter;
+    if (format == "ass") return new AssWriter;
+    if (format == "json") return new JsonWriter;
+    return nullptr;
+}
+
+SubtitleOutput::SubtitleOutput(const QString &basePath, const QStringList &formats)
+    : basePath(basePath)
+{
+    for (const QString &format : formats) {
+        SubtitleWriter *writer = SubtitleWriter::create(format);
+        if (writer != nullptr) {
+            writers.append(writer);
+        }
+    }
+}
+
+SubtitleOutput::~SubtitleOutput()
+{
+    qDeleteAll(writers);
+}
+
+bool SubtitleOutput::write(const QVector<SubtitleCue> &cues, QStringList *writtenFiles, QString *error)
+{
+    // 每种格式一个缓冲区，只遍历一次字幕
+    QVector<QByteArray> buffers(writers.size());
+    for (int w = 0; w < writers.size(); ++w) {
+        buffers[w].reserve(cues.size() * kBytesPerCue);
+        writers[w]->writeHeader(buffers[w]);
+    }
+
+    for (int i = 0; i < cues.size(); ++i) {
+        for (int w = 0; w < writers.size(); ++w) {
+            writers[w]->writeCue(buffers[w], i, cues[i]);
+        }
+    }
+
+    for (int w = 0; w < writers.size(); ++w) {
+        writers[w]->writeFooter(buffers[w]);
+    }
+
+    // 先全部写入临时文件，都成功后再逐个替换
+    QVector<QSaveFile *> files;
+    bool ok = true;
+    for (int w = 0; w < writers.size() && ok; ++w) {
+        QSaveFile *file = new QSaveFile(basePath + writers[w]->suffix());
+        files.append(file);
+
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Text) || file->write(buffers[w]) != buffers[w].size()) {
+            *error = file->fileName() + ": " + file->errorString();
+            ok = false;
+        }
+    }
+
+    writtenFiles->clear();
+    for (QSaveFile *file : files) {
+        if (!ok) {
+            file->cancelWriting();
+        } else if (file->commit()) {
+            writtenFiles->append(file->fileName());
+        } else {
+            *error = file->fileName() + ": " + file->errorString();
+            ok = false;
+        }
+    }
+
+    qDeleteAll(files);
+    return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef SUBTITLEWRITER_H
+#define SUBTITLEWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "subtitlecue.h"
+
+// 一种字幕输出格式，只负责把字幕追加到缓冲区
+class SubtitleWriter
+{
+public:
+    virtual ~SubtitleWriter() {}
+
+    // 输出文件扩展名，如 ".srt"
+    virtual QString suffix() const = 0;
+
+    virtual void writeHeader(QByteArray &out) { Q_UNUSED(out); }
+    virtual void writeCue(QByteArray &out, int index, const SubtitleCue &cue) = 0;
+    virtual void writeFooter(QByteArray &out) { Q_UNUSED(out); }
+
+    // 按格式名创建: srt, txt, vtt, ass, json，未知格式返回空
+    static SubtitleWriter *create(const QString &format);
+};
+
+// 一次遍历字幕，同时生成多种格式，全部成功后通过临时文件+重命名替换输出文件
+class SubtitleOutput
+{
+public:
+    SubtitleOutput(const QString &basePath, const QStringList &formats);
+    ~SubtitleOutput();
+
+    // 成功时 writtenFiles 为生成的文件列表，失败时 error 为错误信息
+    bool write(const QVector<SubtitleCue> &cues, QStringList *writtenFiles, QString *error);
+
+private:
+    QString basePath;
+    QVector<SubtitleWriter *> writers;
+};
+
+#endif // SUBTITLEWRITER_H
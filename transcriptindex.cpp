@@ -0,0 +1,530 @@
+#include "transcriptindex.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+static const char kSegmentMagic[8] = { 'V', '2', 'S', 'T', 'I', 'X', '0', '1' };
+static const int kSegmentHeaderSize = 16;
+static const quint64 kMinRewriteBytes = 1024 * 1024;
+static const int kWriteBufferBytes = 1024 * 1024;
+
+// 倒排段词表项
+struct TermEntry {
+    quint32 hash;
+    quint32 count;
+    quint64 offset;
+};
+
+// 字幕记录文件中每条记录的头部，后接 textBytes 字节的UTF-8文本
+struct CueRecordHeader {
+    quint32 fileId;
+    quint32 textBytes;
+    qint64 startMs;
+    qint64 endMs;
+};
+
+static bool isCjk(QChar ch)
+{
+    switch (ch.script()) {
+    case QChar::Script_Han:
+    case QChar::Script_Hiragana:
+    case QChar::Script_Katakana:
+    case QChar::Script_Hangul:
+        return true;
+    default:
+        return false;
+    }
+}
+
+TranscriptIndex::TranscriptIndex(const QString &dirPath)
+    : dirPath(dirPath)
+    , nextFileId(1)
+    , nextSegmentId(1)
+    , deadBytes(0)
+    , segments(dirPath, QByteArray(kSegmentMagic, sizeof(kSegmentMagic)), kSegmentHeaderSize)
+    , cueFileName("cues.dat")
+    , cueData(nullptr)
+    , cueSize(0)
+{
+    QStringList names;
+
+    QFile file(dirPath + "/files.json");
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        file.close();
+
+        QJsonObject obj = doc.object();
+        nextFileId = static_cast<quint32>(obj.value("nextFileId").toDouble(1));
+        nextSegmentId = obj.value("nextSegment").toInt(1);
+        deadBytes = static_cast<quint64>(obj.value("deadBytes").toDouble());
+        cueFileName = obj.value("cues").toString("cues.dat");
+
+        QJsonObject bytes = obj.value("bytes").toObject();
+        for (auto it = bytes.begin(); it != bytes.end(); ++it) {
+            fileBytes.insert(it.key().toUInt(), static_cast<quint64>(it.value().toDouble()));
+        }
+
+        QJsonObject files = obj.value("files").toObject();
+        for (auto it = files.begin(); it != files.end(); ++it) {
+            quint32 fileId = static_cast<quint32>(it.value().toDouble());
+            fileIds.insert(it.key(), fileId);
+            filePaths.insert(fileId, it.key());
+        }
+
+        for (const QJsonValue &value : obj.value("segments").toArray()) {
+            names.append(value.toString());
+        }
+    }
+
+    // 合并或重写后、更新 files.json 前中断留下的文件
+    SegmentSet::removeUnlisted(dirPath, QStringList() << "seg_*.idx" << "cues_*.dat", QStringList(names) << cueFileName);
+
+    remapCues();
+    segments.append(names);
+}
+
+TranscriptIndex::~TranscriptIndex()
+{
+    cueFile.close();
+}
+
+bool TranscriptIndex::addTranscript(const QString &filePath, const QVector<SubtitleCue> &cues)
+{
+    QMutexLocker writeLocker(&writeMutex);
+
+    if (!QDir().mkpath(dirPath)) {
+        return false;
+    }
+
+    // 同一文件重新转写时，旧记录随文件ID一起失效
+    if (fileIds.contains(filePath)) {
+        quint32 oldId = fileIds.take(filePath);
+        deadBytes += fileBytes.take(oldId);
+        QMutexLocker locker(&mutex);
+        filePaths.remove(oldId);
+    }
+
+    QString name;
+    if (!cues.isEmpty()) {
+        quint32 fileId = nextFileId++;
+
+        // 追加字幕记录，同时收集倒排表
+        QFile out(dirPath + "/" + cueFileName);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            return false;
+        }
+
+        quint64 offset = static_cast<quint64>(out.size());
+        QHash<quint32, QVector<quint64>> postings;
+        QByteArray buffer;
+
+        for (const SubtitleCue &cue : cues) {
+            QByteArray text = cue.text.toUtf8();
+            CueRecordHeader header = { fileId, static_cast<quint32>(text.size()), cue.startMs, cue.endMs };
+            buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+            buffer.append(text);
+
+            for (quint32 token : tokenize(cue.text, false)) {
+                postings[token].append(offset);
+            }
+            offset += sizeof(header) + text.size();
+        }
+
+        bool writeOk = out.write(buffer) == buffer.size();
+        out.close();
+        if (!writeOk) {
+            return false;
+        }
+
+        name = QString("seg_%1.idx").arg(nextSegmentId++);
+        if (!writeSegment(name, postings)) {
+            return false;
+        }
+
+        fileIds.insert(filePath, fileId);
+        fileBytes.insert(fileId, static_cast<quint64>(buffer.size()));
+
+        QMutexLocker locker(&mutex);
+        filePaths.insert(fileId, filePath);
+        remapCues();
+    }
+
+    if (!segments.commit(segments.segments().size(), name, [this](const QStringList &names) { return saveFiles(names); },
+                         &mutex)) {
+        return false;
+    }
+
+    // 失效记录过半时重写字幕记录文件，否则合并级别相同的最新段
+    if (deadBytes >= kMinRewriteBytes && deadBytes * 2 > static_cast<quint64>(cueSize)) {
+        rewriteCues();
+        return true;
+    }
+    for (int first = segments.mergeStart(); first >= 0; first = segments.mergeStart()) {
+        if (!mergeSegments(first)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+QVector<TranscriptHit> TranscriptIndex::search(const QString &query, int limit)
+{
+    QMutexLocker locker(&mutex);
+    QVector<TranscriptHit> hits;
+
+    QString needle = query.trimmed().toLower();
+    QSet<quint32> tokens = tokenize(needle, true);
+    if (tokens.isEmpty()) {
+        return hits;
+    }
+
+    for (int i = segments.segments().size() - 1; i >= 0; --i) {
+        // 求所有词的倒排表交集
+        QVector<quint64> candidates;
+        bool first = true;
+        for (quint32 token : tokens) {
+            QVector<quint64> postings = findPostings(segments.segments()[i], token);
+            if (first) {
+                candidates = postings;
+                first = false;
+            } else {
+                QVector<quint64> merged;
+                std::set_intersection(candidates.begin(), candidates.end(),
+                                      postings.begin(), postings.end(),
+                                      std::back_inserter(merged));
+                candidates = merged;
+            }
+            if (candidates.isEmpty()) {
+                break;
+            }
+        }
+
+        // 记录按加入顺序追加，偏移从大到小即最新的在前；词序和哈希冲突由原文比对排除
+        for (int c = candidates.size() - 1; c >= 0; --c) {
+            quint64 offset = candidates[c];
+            quint32 fileId;
+            SubtitleCue cue;
+            if (!readCue(offset, &fileId, &cue) || !filePaths.contains(fileId)) {
+                continue;
+            }
+            if (!cue.text.toLower().contains(needle)) {
+                continue;
+            }
+
+            hits.append({ filePaths.value(fileId), cue.startMs, cue.endMs, cue.text });
+            if (hits.size() >= limit) {
+                return hits;
+            }
+        }
+    }
+
+    return hits;
+}
+
+QSet<quint32> TranscriptIndex::tokenize(const QString &text, bool forQuery)
+{
+    QSet<quint32> tokens;
+    QString lower = text.toLower();
+    int i = 0;
+
+    while (i < lower.size()) {
+        if (isCjk(lower[i])) {
+            int start = i;
+            while (i < lower.size() && isCjk(lower[i])) {
+                i++;
+            }
+            int length = i - start;
+
+            // 索引单字和二字，查询时二字更有区分度，只在单字查询时用单字
+            if (!forQuery || length == 1) {
+                for (int k = 0; k < length; ++k) {
+                    tokens.insert(hashToken(lower.mid(start + k, 1)));
+                }
+            }
+            for (int k = 0; k + 1 < length; ++k) {
+                tokens.insert(hashToken(lower.mid(start + k, 2)));
+            }
+        } else if (lower[i].isLetterOrNumber()) {
+            int start = i;
+            while (i < lower.size() && lower[i].isLetterOrNumber() && !isCjk(lower[i])) {
+                i++;
+            }
+            tokens.insert(hashToken(lower.mid(start, i - start)));
+        } else {
+            i++;
+        }
+    }
+
+    return tokens;
+}
+
+quint32 TranscriptIndex::hashToken(const QString &token)
+{
+    // FNV-1a，结果写入磁盘，不能使用带随机种子的 qHash
+    quint32 hash = 2166136261u;
+    for (char c : token.toUtf8()) {
+        hash ^= static_cast<quint8>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool TranscriptIndex::saveFiles(const QStringList &segmentNames)
+{
+    QJsonObject files;
+    for (auto it = fileIds.constBegin(); it != fileIds.constEnd(); ++it) {
+        files[it.key()] = static_cast<double>(it.value());
+    }
+
+    QJsonObject bytes;
+    for (auto it = fileBytes.constBegin(); it != fileBytes.constEnd(); ++it) {
+        bytes[QString::number(it.key())] = static_cast<double>(it.value());
+    }
+
+    QJsonObject obj;
+    obj["nextFileId"] = static_cast<double>(nextFileId);
+    obj["nextSegment"] = nextSegmentId;
+    obj["files"] = files;
+    obj["bytes"] = bytes;
+    obj["deadBytes"] = static_cast<double>(deadBytes);
+    obj["cues"] = cueFileName;
+    obj["segments"] = QJsonArray::fromStringList(segmentNames);
+
+    QSaveFile file(dirPath + "/files.json");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(QJsonDocument(obj).toJson());
+    return file.commit();
+}
+
+bool TranscriptIndex::writeSegment(const QString &name, const QHash<quint32, QVector<quint64>> &postings)
+{
+    QVector<quint32> terms = postings.keys().toVector();
+    std::sort(terms.begin(), terms.end());
+
+    QSaveFile file(dirPath + "/" + name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    quint32 termCount = static_cast<quint32>(terms.size());
+    quint32 reserved = 0;
+    file.write(kSegmentMagic, sizeof(kSegmentMagic));
+    file.write(reinterpret_cast<const char *>(&termCount), sizeof(termCount));
+    file.write(reinterpret_cast<const char *>(&reserved), sizeof(reserved));
+
+    // 词表，偏移为倒排表在文件中的绝对位置
+    QByteArray table;
+    quint64 offset = kSegmentHeaderSize + static_cast<quint64>(termCount) * sizeof(TermEntry);
+    for (quint32 term : terms) {
+        const QVector<quint64> list = postings.value(term);
+        TermEntry entry = { term, static_cast<quint32>(list.size()), offset };
+        table.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        offset += list.size() * sizeof(quint64);
+    }
+    file.write(table);
+
+    for (quint32 term : terms) {
+        const QVector<quint64> list = postings.value(term);
+        file.write(reinterpret_cast<const char *>(list.constData()), list.size() * sizeof(quint64));
+    }
+
+    return file.commit();
+}
+
+bool TranscriptIndex::mergeSegments(int first)
+{
+    // 合并 first 之后的段，丢弃已失效文件的记录；各段按加入顺序拼接，倒排表保持有序
+    QHash<quint32, QVector<quint64>> postings;
+    for (int i = first; i < segments.segments().size(); ++i) {
+        const SegmentSet::Segment &segment = segments.segments()[i];
+        quint32 termCount;
+        memcpy(&termCount, segment.data + sizeof(kSegmentMagic), sizeof(termCount));
+
+        for (quint32 t = 0; t < termCount; ++t) {
+            TermEntry entry;
+            memcpy(&entry, segment.data + kSegmentHeaderSize + t * sizeof(TermEntry), sizeof(entry));
+
+            QVector<quint64> &list = postings[entry.hash];
+            for (quint64 offset : findPostings(segment, entry.hash)) {
+                if (offset + sizeof(CueRecordHeader) > static_cast<quint64>(cueSize)) {
+                    continue;
+                }
+                quint32 fileId;
+                memcpy(&fileId, cueData + offset, sizeof(fileId));
+                if (filePaths.contains(fileId)) {
+                    list.append(offset);
+                }
+            }
+            if (list.isEmpty()) {
+                postings.remove(entry.hash);
+            }
+        }
+    }
+
+    QString name = QString("seg_%1.idx").arg(nextSegmentId++);
+    if (!writeSegment(name, postings)) {
+        return false;
+    }
+
+    // files.json 指向新段之后才删除旧段
+    return segments.commit(first, name, [this](const QStringList &names) { return saveFiles(names); }, &mutex);
+}
+
+bool TranscriptIndex::rewriteCues()
+{
+    // 只保留有效文件的记录，写入新的字幕记录文件，并按新偏移重建为一个段
+    QString newCueName = QString("cues_%1.dat").arg(nextSegmentId++);
+    QString name = QString("seg_%1.idx").arg(nextSegmentId++);
+
+    QSaveFile out(dirPath + "/" + newCueName);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QHash<quint32, QVector<quint64>> postings;
+    QHash<quint32, quint64> liveBytes;
+    QByteArray buffer;
+    quint64 offset = 0;
+    quint64 newOffset = 0;
+    quint32 fileId;
+    SubtitleCue cue;
+    while (readCue(offset, &fileId, &cue)) {
+        CueRecordHeader header;
+        memcpy(&header, cueData + offset, sizeof(header));
+        quint64 recordBytes = sizeof(header) + header.textBytes;
+
+        if (filePaths.contains(fileId)) {
+            buffer.append(reinterpret_cast<const char *>(cueData + offset), static_cast<int>(recordBytes));
+            for (quint32 token : tokenize(cue.text, false)) {
+                postings[token].append(newOffset);
+            }
+            liveBytes[fileId] += recordBytes;
+            newOffset += recordBytes;
+
+            if (buffer.size() >= kWriteBufferBytes) {
+                out.write(buffer);
+                buffer.clear();
+            }
+        }
+        offset += recordBytes;
+    }
+    out.write(buffer);
+
+    if (!out.commit()) {
+        return false;
+    }
+    if (!writeSegment(name, postings)) {
+        QFile::remove(dirPath + "/" + newCueName);
+        return false;
+    }
+
+    // files.json 指向新文件之后才删除旧文件
+    QString oldCueName = cueFileName;
+    QHash<quint32, quint64> oldFileBytes = fileBytes;
+    quint64 oldDeadBytes = deadBytes;
+    cueFileName = newCueName;
+    fileBytes = liveBytes;
+    deadBytes = 0;
+    if (!saveFiles(QStringList() << name)) {
+        cueFileName = oldCueName;
+        fileBytes = oldFileBytes;
+        deadBytes = oldDeadBytes;
+        QFile::remove(dirPath + "/" + newCueName);
+        QFile::remove(dirPath + "/" + name);
+        return false;
+    }
+
+    // 段和字幕记录映射一起替换，搜索不会用新段的偏移读旧文件
+    QStringList oldNames;
+    {
+        QMutexLocker locker(&mutex);
+        oldNames = segments.replace(0, name);
+        remapCues();
+    }
+    segments.removeFiles(oldNames);
+    QFile::remove(dirPath + "/" + oldCueName);
+    return true;
+}
+
+QVector<quint64> TranscriptIndex::findPostings(const SegmentSet::Segment &segment, quint32 hash) const
+{
+    QVector<quint64> result;
+
+    quint32 termCount;
+    memcpy(&termCount, segment.data + sizeof(kSegmentMagic), sizeof(termCount));
+    if (qint64(kSegmentHeaderSize + termCount * sizeof(TermEntry)) > segment.size) {
+        return result;
+    }
+
+    // 词表按哈希排序，二分查找
+    quint32 lo = 0;
+    quint32 hi = termCount;
+    while (lo < hi) {
+        quint32 mid = lo + (hi - lo) / 2;
+        quint32 midHash;
+        memcpy(&midHash, segment.data + kSegmentHeaderSize + mid * sizeof(TermEntry), sizeof(midHash));
+        if (midHash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo >= termCount) {
+        return result;
+    }
+
+    TermEntry entry;
+    memcpy(&entry, segment.data + kSegmentHeaderSize + lo * sizeof(TermEntry), sizeof(entry));
+    if (entry.hash != hash || entry.offset + entry.count * sizeof(quint64) > static_cast<quint64>(segment.size)) {
+        return result;
+    }
+
+    result.resize(static_cast<int>(entry.count));
+    memcpy(result.data(), segment.data + entry.offset, entry.count * sizeof(quint64));
+    return result;
+}
+
+void TranscriptIndex::remapCues()
+{
+    if (cueData != nullptr) {
+        cueFile.unmap(const_cast<uchar *>(cueData));
+    }
+    cueFile.close();
+    cueData = nullptr;
+    cueSize = 0;
+
+    cueFile.setFileName(dirPath + "/" + cueFileName);
+    if (cueFile.open(QIODevice::ReadOnly)) {
+        cueSize = cueFile.size();
+        if (cueSize > 0) {
+            cueData = cueFile.map(0, cueSize);
+        }
+    }
+}
+
+bool TranscriptIndex::readCue(quint64 offset, quint32 *fileId, SubtitleCue *cue) const
+{
+    if (cueData == nullptr || offset + sizeof(CueRecordHeader) > static_cast<quint64>(cueSize)) {
+        return false;
+    }
+
+    CueRecordHeader header;
+    memcpy(&header, cueData + offset, sizeof(header));
+    if (offset + sizeof(header) + header.textBytes > static_cast<quint64>(cueSize)) {
+        return false;
+    }
+
+    *fileId = header.fileId;
+    cue->startMs = header.startMs;
+    cue->endMs = header.endMs;
+    cue->text = QString::fromUtf8(reinterpret_cast<const char *>(cueData + offset + sizeof(header)),
+                                  static_cast<int>(header.textBytes));
+    return true;
+}
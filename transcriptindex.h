@@ -0,0 +1,73 @@
+#ifndef TRANSCRIPTINDEX_H
+#define TRANSCRIPTINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QFile>
+#include <QMutex>
+#include "subtitlecue.h"
+#include "segmentset.h"
+
+// 一条搜索结果
+struct TranscriptHit {
+    QString filePath;
+    qint64 startMs;
+    qint64 endMs;
+    QString text;
+};
+
+// 所有已处理媒体字幕的全文检索索引
+//
+// 中日韩文字按单字和相邻二字切分，其余文字按单词切分。
+// 每次加入一份字幕生成一个新的倒排段，最新的几个段大小相近时合并，段文件通过内存映射查找。
+// 重新转写留下的失效记录过半时，重写字幕记录文件并重建为一个段。
+// 写入由 writeMutex 串行化，段和字幕记录文件在锁外生成，只在替换段列表和映射时短暂持有 mutex，
+// 界面线程中的搜索不会等待合并或重写。
+// 目录结构:
+//   files.json     媒体文件路径到文件ID的映射、当前的字幕记录文件和段列表
+//   cues.dat       追加写入的字幕记录 (文件ID, 文本长度, 起止时间, UTF-8文本)，重写后为 cues_<n>.dat
+//   seg_<n>.idx    倒排段: 按词哈希排序的词表 + 字幕记录偏移列表
+class TranscriptIndex
+{
+public:
+    explicit TranscriptIndex(const QString &dirPath);
+    ~TranscriptIndex();
+
+    // 加入(或替换)一个媒体文件的字幕
+    bool addTranscript(const QString &filePath, const QVector<SubtitleCue> &cues);
+
+    // 查找包含 query 的字幕，最新加入的文件在前
+    QVector<TranscriptHit> search(const QString &query, int limit = 200);
+
+private:
+    QString dirPath;
+    QMutex writeMutex;                  // 串行化写入，下列成员只由持有它的线程修改
+    QMutex mutex;                       // 保护搜索读取的 filePaths、segments 和字幕记录映射
+    QHash<QString, quint32> fileIds;    // 当前有效的文件
+    QHash<quint32, QString> filePaths;
+    QHash<quint32, quint64> fileBytes;  // 各有效文件在字幕记录文件中占用的字节数
+    quint32 nextFileId;
+    int nextSegmentId;
+    quint64 deadBytes;                  // 失效记录占用的字节数
+    SegmentSet segments;
+    QString cueFileName;
+    QFile cueFile;
+    const uchar *cueData;
+    qint64 cueSize;
+
+    static QSet<quint32> tokenize(const QString &text, bool forQuery);
+    static quint32 hashToken(const QString &token);
+
+    bool saveFiles(const QStringList &segmentNames);
+    bool writeSegment(const QString &name, const QHash<quint32, QVector<quint64>> &postings);
+    bool mergeSegments(int first);
+    bool rewriteCues();
+    QVector<quint64> findPostings(const SegmentSet::Segment &segment, quint32 hash) const;
+    void remapCues();                   // 调用方持有 mutex
+    bool readCue(quint64 offset, quint32 *fileId, SubtitleCue *cue) const;
+};
+
+#endif // TRANSCRIPTINDEX_H
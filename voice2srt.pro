@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent multimedia multimediawidgets
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -25,10 +25,21 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        audiofingerprint.cpp \
+        transcriptindex.cpp \
+        segmentset.cpp \
+        subtitlewriter.cpp \
+        whisperoutput.cpp
 
 HEADERS += \
-        mainwindow.h
+        mainwindow.h \
+        subtitlecue.h \
+        audiofingerprint.h \
+        transcriptindex.h \
+        segmentset.h \
+        subtitlewriter.h \
+        whisperoutput.h
 
 FORMS += \
         mainwindow.ui
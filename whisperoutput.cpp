@@ -0,0 +1,165 @@
+#include "whisperoutput.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QVariant>
+
+// UTF-8 中3、4字节编码的字符(中日韩文字、全角标点等)各自成词
+static bool isWideLead(uchar c)
+{
+    return c >= 0xE0;
+}
+
+// 末尾没有被截断的多字节字符
+static bool isCompleteUtf8(const QByteArray &bytes)
+{
+    int i = bytes.size() - 1;
+    int continuation = 0;
+    while (i >= 0 && continuation < 3 && (static_cast<uchar>(bytes[i]) & 0xC0) == 0x80) {
+        i--;
+        continuation++;
+    }
+    if (i < 0) {
+        return continuation == 0;
+    }
+
+    uchar lead = static_cast<uchar>(bytes[i]);
+    int length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    return continuation + 1 >= length;
+}
+
+static bool endsWithWideChar(const QByteArray &bytes)
+{
+    int i = bytes.size() - 1;
+    while (i > 0 && (static_cast<uchar>(bytes[i]) & 0xC0) == 0x80) {
+        i--;
+    }
+    return i >= 0 && isWideLead(static_cast<uchar>(bytes[i]));
+}
+
+// whisper 的 token 是字节级BPE片段，一个汉字可能被拆到几个 token 中，英文单词前的空格属于该单词的 token。
+// 字节拼完整后在空格处、宽字符前后断开，得到完整的词；词的置信度取其中最低的 token
+QVector<SubtitleWord> WhisperOutput::mergeTokens(const QJsonArray &tokens, bool latin1)
+{
+    QVector<SubtitleWord> words;
+    QByteArray pending;
+    SubtitleWord word = { 0, 0, QString(), 1.0 };
+
+    auto flush = [&]() {
+        word.text = QString::fromUtf8(pending).trimmed();
+        if (!word.text.isEmpty()) {
+            words.append(word);
+        }
+        pending.clear();
+    };
+
+    for (const QJsonValue &tokenValue : tokens) {
+        QJsonObject token = tokenValue.toObject();
+        QString text = token.value("text").toString();
+
+        // 跳过 [_BEG_]、[_TT_xxx] 等特殊标记
+        if (text.startsWith("[_")) {
+            continue;
+        }
+
+        QByteArray bytes = latin1 ? text.toLatin1() : text.toUtf8();
+        if (bytes.isEmpty()) {
+            continue;
+        }
+
+        if (!pending.isEmpty() && isCompleteUtf8(pending) &&
+            (bytes[0] == ' ' || endsWithWideChar(pending) || isWideLead(static_cast<uchar>(bytes[0])))) {
+            flush();
+        }
+
+        QJsonObject offsets = token.value("offsets").toObject();
+        double confidence = token.value("p").toDouble();
+        if (pending.isEmpty()) {
+            word.startMs = offsets.value("from").toVariant().toLongLong();
+            word.confidence = confidence;
+        }
+        word.endMs = offsets.value("to").toVariant().toLongLong();
+        word.confidence = qMin(word.confidence, confidence);
+        pending += bytes;
+    }
+    if (!pending.isEmpty()) {
+        flush();
+    }
+
+    return words;
+}
+
+void WhisperOutput::parseLine(const QString &line, QVector<SubtitleCue> *cues, int firstCue)
+{
+    // 正则表达式匹配时间戳格式 [HH:MM:SS.XXX --> HH:MM:SS.XXX]
+    static const QRegularExpression timeStampRegex("\\[(\\d\\d):(\\d\\d):(\\d\\d)\\.(\\d\\d\\d) --> (\\d\\d):(\\d\\d):(\\d\\d)\\.(\\d\\d\\d)\\]");
+
+    QString trimmedLine = line.trimmed();
+
+    // 跳过空行
+    if (trimmedLine.isEmpty()) {
+        return;
+    }
+
+    // 检查是否为时间戳行
+    QRegularExpressionMatch match = timeStampRegex.match(trimmedLine);
+    if (match.hasMatch()) {
+        SubtitleCue cue;
+        cue.startMs = match.captured(1).toInt() * 3600000LL + match.captured(2).toInt() * 60000LL +
+                      match.captured(3).toInt() * 1000LL + match.captured(4).toInt();
+        cue.endMs = match.captured(5).toInt() * 3600000LL + match.captured(6).toInt() * 60000LL +
+                    match.captured(7).toInt() * 1000LL + match.captured(8).toInt();
+
+        // 提取时间戳后的文本
+        int textStart = trimmedLine.indexOf("]") + 1;
+        cue.text = trimmedLine.mid(textStart).trimmed();
+        cues->append(cue);
+        return;
+    }
+
+    // 处理可能的多行字幕文本，只接在本片段识别出的字幕后面
+    if (cues->size() > firstCue) {
+        SubtitleCue &last = cues->last();
+        last.text = last.text.isEmpty() ? trimmedLine : last.text + "\n" + trimmedLine;
+    }
+}
+
+bool WhisperOutput::attachWordTimings(const QByteArray &json, QVector<SubtitleCue> *cues, int firstCue, QString *error)
+{
+    // whisper 按原始字节输出 token 文本，被拆开的汉字使整个文件不是合法的UTF-8。
+    // 此时按Latin-1把每个字节当作一个字符再解析，token 文本用 toLatin1() 还原字节
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    bool latin1 = false;
+    if (parseError.error == QJsonParseError::IllegalUTF8String) {
+        doc = QJsonDocument::fromJson(QString::fromLatin1(json).toUtf8(), &parseError);
+        latin1 = true;
+    }
+    if (parseError.error != QJsonParseError::NoError) {
+        *error = parseError.errorString();
+        return false;
+    }
+
+    // 格式: {"transcription": [{"offsets": {"from", "to"}, "tokens": [{"text", "offsets", "p"}]}]}
+    QJsonArray segments = doc.object().value("transcription").toArray();
+
+    int cueIndex = firstCue;
+    for (const QJsonValue &segmentValue : segments) {
+        QJsonObject segment = segmentValue.toObject();
+        qint64 from = segment.value("offsets").toObject().value("from").toVariant().toLongLong();
+
+        // 按起始时间对应到标准输出中解析出的字幕
+        while (cueIndex < cues->size() && (*cues)[cueIndex].startMs < from) {
+            cueIndex++;
+        }
+        if (cueIndex >= cues->size()) {
+            break;
+        }
+        if ((*cues)[cueIndex].startMs != from) {
+            continue;
+        }
+
+        (*cues)[cueIndex].words = mergeTokens(segment.value("tokens").toArray(), latin1);
+    }
+    return true;
+}
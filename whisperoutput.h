@@ -0,0 +1,26 @@
+#ifndef WHISPEROUTPUT_H
+#define WHISPEROUTPUT_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QString>
+#include <QVector>
+#include "subtitlecue.h"
+
+// 解析 wav2srt(whisper) 的输出，不依赖界面
+class WhisperOutput
+{
+public:
+    // 解析标准输出的一行: 时间戳行追加一条字幕，其余非空行并入上一条字幕。
+    // 续行只接在 firstCue 及之后的字幕上，之前的字幕属于其他识别片段
+    static void parseLine(const QString &line, QVector<SubtitleCue> *cues, int firstCue);
+
+    // 从 -ojf 输出的JSON中读取逐词时间，按起始时间附加到 firstCue 及之后的字幕；
+    // 无法解析时返回 false，error 为错误信息
+    static bool attachWordTimings(const QByteArray &json, QVector<SubtitleCue> *cues, int firstCue, QString *error);
+
+    // 把一个片段的 token 合并为词，latin1 为 true 时 token 文本的每个字符是一个原始字节
+    static QVector<SubtitleWord> mergeTokens(const QJsonArray &tokens, bool latin1);
+};
+
+#endif // WHISPEROUTPUT_H